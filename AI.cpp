@@ -1,9 +1,15 @@
 #include "AI.h"
 
 std::array<double, 6> AI::sPiecesValues = { 1, 3.2, 3.3, 5, 9, 1000 };
+const u8 AI::sMaxDepth = 64;
+const double AI::sTablebaseWin = 500;
 
 AI::AI(size_t transpositionTableSize) :
-	mTranspositionTable(transpositionTableSize)
+	mTranspositionTable(transpositionTableSize),
+	mSearching(false),
+	mVerbose(true),
+	mUsesNetwork(true),
+	mMultiPV(1)
 {
 	mPositionalScore[Pawn] =
 		{ 0., 0., 0., 0., 0., 0., 0., 0.,
@@ -16,20 +22,20 @@ AI::AI(size_t transpositionTableSize) :
 		  0., 0., 0., 0., 0., 0., 0., 0. };
 
 	mPositionalScore[Knight] =
-		{ 0., 0., 0., 0., 0., 0., 0., 0.,
-		  .05, .10, .10, -.20, -.20, .10, .10, .05,
-		  .05, -.05, -.10, 0., 0., -.10, -.05, .05,
-		  0., 0., 0., .20, .20, 0., 0., 0.,
-		  .05, .05, .10, .25, .25, .10, .05, .05,
-		  .10, .10, .20, .30, .30, .20, .10, .10,
-		  .50, .50, .50, .50, .50, .50, .50, .50,
-		  0., 0., 0., 0., 0., 0., 0., 0. };
+		{ -.50, -.40, -.30, -.30, -.30, -.30, -.40, -.50,
+		  -.40, -.20, 0., .05, .05, 0., -.20, -.40,
+		  -.30, .05, .10, .15, .15, .10, .05, -.30,
+		  -.30, 0., .15, .20, .20, .15, 0., -.30,
+		  -.30, .05, .15, .20, .20, .15, .05, -.30,
+		  -.30, 0., .10, .15, .15, .10, 0., -.30,
+		  -.40, -.20, 0., 0., 0., 0., -.20, -.40,
+		  -.50, -.40, -.30, -.30, -.30, -.30, -.40, -.50 };
 
 	mPositionalScore[Bishop] =
 		{ -.20, -.10, -.10, -.10, -.10, -.10, -.10, -.20,
 		  -.10, .05, 0., 0., 0., 0., .05, -.10,
 		  -.10, .10, .10, .10, .10, .10, .10, -.10,
-		  -.10, 0., .10, .10, 10., .10, 0., -.10,
+		  -.10, 0., .10, .10, .10, .10, 0., -.10,
 		  -.10, .05, .05, .10, .10, .05, .05, -.10,
 		  -.10, 0., .05, .10, .10, .05, 0., -.10,
 		  -.10, 0., 0., 0., 0., 0., 0., -.10,
@@ -64,86 +70,337 @@ AI::AI(size_t transpositionTableSize) :
 		  0., 0., 0., 0., 0., 0., 0., 0., 
 		  0., 0., 0., 0., 0., 0., 0., 0., 
 		  0., 0., 0., 0., 0., 0., 0., 0., };
+
+	mEvaluator.setParameters(sPiecesValues, mPositionalScore);
+}
+
+// Search reports on the standard output
+void AI::setVerbose(bool verbose)
+{
+	mVerbose = verbose;
+}
+
+// With a network loaded, evaluates with the tables anyway : the network is shared by all the AIs
+void AI::setUsesNetwork(bool usesNetwork)
+{
+	mUsesNetwork = usesNetwork;
+}
+
+// Number of lines searched by each iteration : the root moves are searched again without the best moves already found
+void AI::setMultiPV(u8 multiPV)
+{
+	mMultiPV = std::max<u8>(multiPV, 1);
+}
+
+// Called after each completed line of each iteration, from the searching thread
+void AI::setInfoCallback(const std::function<void(const IterationStats&)>& infoCallback)
+{
+	mInfoCallback = infoCallback;
+}
+
+void AI::clear()
+{
+	mTranspositionTable.clear();
+	mPrincipalVariation.clear();
+	mLines.clear();
+}
+
+void AI::resizeTranspositionTable(size_t size)
+{
+	mTranspositionTable.resize(size);
+}
+
+// Polyglot book : while open, book positions are answered without searching
+bool AI::openBook(const std::string& book)
+{
+	return mBook.open(book);
+}
+
+void AI::closeBook()
+{
+	mBook.close();
+}
+
+// Position database built by posdb : positions out of the book are answered from the games of the database
+bool AI::openDatabase(const std::string& path)
+{
+	return mDatabase.open(path);
+}
+
+void AI::closeDatabase()
+{
+	mDatabase.close();
+}
+
+// Syzygy directories : the search probes the WDL tables, the root move is chosen from the DTZ tables
+bool AI::setTablebasesPath(const std::string& paths)
+{
+	return mTablebases.init(paths);
 }
 
 Move AI::bestMove(const Game& game, u64 thinkingTime)
 {
-	std::cout << "Eval w : " << _evaluate(game, White) << "\n";
-	std::cout << "Eval b : " << _evaluate(game, Black) << "\n\n";
+	SearchLimits limits;
+	limits.moveTime = thinkingTime;
+
+	return bestMove(game, limits);
+}
+
+Move AI::bestMove(const Game& game, const SearchLimits& limits)
+{
+	SearchStats stats;
+	return bestMove(game, limits, stats);
+}
+
+Move AI::bestMove(const Game& game, const SearchLimits& limits, SearchStats& stats)
+{
+	TRACK_ALLOCATIONS(Search);
+
+	// A ponder or infinite search must last until the stop, it is not answered from the book or the database
+	if ((mBook.isOpen() || mDatabase.isOpen()) && !limits.ponder && !limits.infinite) {
+		bool isBookMove(mBook.isOpen());
+		Move move(isBookMove ? mBook.probe(game) : Move());
+
+		if (move == Move()) {
+			isBookMove = false;
+			move = mDatabase.probe(game);
+		}
+
+		if (move != Move()) {
+			if (mVerbose)
+				std::cout << (isBookMove ? "Book move : " : "Database move : ") << move.toString() << "\n\n";
+
+			mStats.clear();
+			mPrincipalVariation = { move };
+			mLines.clear();
+			stats = mStats;
+
+			return move;
+		}
+	}
+
+#ifdef CHESS_SEARCH_TABLEBASES
+	if (!limits.ponder && !limits.infinite) {
+		Move move(mTablebases.probeRoot(game));
+
+		if (move != Move()) {
+			if (mVerbose)
+				std::cout << "Tablebase move : " << move.toString() << "\n\n";
+
+			mStats.clear();
+			mPrincipalVariation = { move };
+			mLines.clear();
+			stats = mStats;
+
+			return move;
+		}
+	}
+#endif
 
 	// Iterative deepening
 
 	u64 nodes(0);
 	Game root(game);
 
-	u8 depth(1);
-	bool interrupted(false);
+	root.refreshAccumulator();
+
+	if (mVerbose) {
+		std::cout << "Eval w : " << _evaluate(root, White) << "\n";
+		std::cout << "Eval b : " << _evaluate(root, Black) << "\n\n";
+	}
 
-	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	u8 depth(1), maxDepth(limits.depth ? std::min(limits.depth, sMaxDepth) : sMaxDepth);
 
 	Move move;
-	std::list<Move> l, movesSequence;
+	std::list<Move> movesSequence;
+	std::pair<double, std::list<Move>> pair;
 
 	mKillerMoves.clear();
+	mLines.clear();
+
+	mStats.clear();
+	PROFILE_RESET();
 
+	mTimeManager.start(limits);
+	mSearching = true;
 
-	while (!interrupted) {
+	while (true) {
 		mKillerMoves.push_back({ Move(), Move() });
-		l = _pvs(&root, depth, 0, -INFINITY, INFINITY, root.activePlayer(), nodes, interrupted, begin, thinkingTime).second;
+		TRACE_NODE(TraceIteration, Move(), 0, depth, -INFINITY, INFINITY, 0, 0);
+
+		// The lines share the transposition table and the killer moves : the later ones are cheaper
+		std::vector<IterationStats> lines;
+		bool isInterrupted(false);
+		mExcludedMoves.clear();
+
+		while (lines.size() < mMultiPV) {
+			pair = _pvs(&root, depth, 0, -INFINITY, INFINITY, root.activePlayer(), nodes);
+
+			if (mTimeManager.isStopped()) {
+				isInterrupted = true;
+				break;
+			}
+
+			// All the root moves are already in a line : the first pass is kept even without a legal move
+			if (!lines.empty() && pair.second.front() == Move())
+				break;
 
-		if (!interrupted) {
-			movesSequence = l;
-			move = movesSequence.front();
-			++depth;
+			lines.push_back({ depth, mTimeManager.elapsed(), nodes, mStats.qnodes, pair.first, pair.second, u8(lines.size() + 1) });
+			mExcludedMoves.push_back(pair.second.front());
+
+			if (mInfoCallback)
+				mInfoCallback(lines.back());
 		}
-	}
 
-	std::cout << "Search speed: " << int(double(nodes) / double(thinkingTime)) << " kN/s\n";
-	std::cout << "Depth: " << int(depth - 1) << "\n";
-	std::cout << "TT filling rate : " << 100 * double(mTranspositionTable.entries()) / double(mTranspositionTable.size()) << "%\n\n";
+		mExcludedMoves.clear();
 
-	std::cout << "Moves sequence :\n";
+		// A stop sent from the info callback of the last line does not interrupt the iteration
+		if (isInterrupted) {
+			// Keep the best move of the interrupted iteration if at least one root move was fully searched
+			if (!lines.empty()) {
+				movesSequence = lines.front().principalVariation;
+				move = movesSequence.front();
+			} else if (pair.first > -INFINITY && !pair.second.empty()) {
+				movesSequence = pair.second;
+				move = movesSequence.front();
+			}
 
-	for (const Move& move : movesSequence) {
-		std::cout << "   * " << int(move.from()) << " to " << int(move.to()) << "\n";
+			// The lines of the previous iteration complete those of the interrupted one
+			for (const IterationStats& line : mLines) {
+				if (std::none_of(lines.begin(), lines.end(), [&line](const IterationStats& l) { return l.principalVariation.front() == line.principalVariation.front(); })) {
+					lines.push_back(line);
+					lines.back().line = u8(lines.size());
+				}
+			}
+
+			if (!lines.empty())
+				mLines = lines;
+
+			break;
+		}
+
+		// A later line can end up better than an earlier one when the search is unstable
+		std::stable_sort(lines.begin(), lines.end(), [](const IterationStats& l1, const IterationStats& l2) { return l1.score > l2.score; });
+
+		for (size_t i(0); i < lines.size(); ++i)
+			lines[i].line = u8(i + 1);
+
+		mTimeManager.iterationDone(depth > 1 && lines.front().principalVariation.front() != move);
+
+		movesSequence = lines.front().principalVariation;
+		move = movesSequence.front();
+		mLines = lines;
+
+		mStats.iterations.push_back(lines.front());
+
+		++depth;
+
+		// A ponder or infinite search cannot return before the ponder hit or the stop
+		if (depth > maxDepth) {
+			while ((mTimeManager.isPondering() || mTimeManager.isInfinite()) && !mTimeManager.isStopped())
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+			break;
+		}
+
+		if (!mTimeManager.canStartIteration())
+			break;
+	}
+
+	mStats.time = mTimeManager.elapsed();
+	mStats.nodes = nodes;
+
+	if (mVerbose) {
+		std::cout << "Search speed: " << int(double(nodes) / double(std::max<u64>(mStats.time, 1))) << " kN/s\n";
+		std::cout << "Depth: " << int(depth - 1) << "\n";
+		std::cout << "Quiescence nodes: " << mStats.qnodes << " (" << mStats.seePrunings << " losing captures pruned)\n";
+		std::cout << "Branching factor: " << mStats.branchingFactor() << "\n";
+		std::cout << "First move cutoffs: " << 100 * mStats.firstMoveCutoffRate() << "%\n";
+		std::cout << "TT hits : " << mStats.ttHits << "/" << mStats.ttProbes << " (" << mStats.ttCutoffs << " cutoffs)\n";
+#ifdef CHESS_SEARCH_TABLEBASES
+		std::cout << "Tablebase probes : " << mStats.tbHits << "/" << mStats.tbProbes << " (cache hit rate " << 100 * double(mStats.tbCacheHits) / double(std::max<u64>(mStats.tbProbes, 1)) << "%)\n";
+#endif
+		std::cout << "TT filling rate : " << 100 * double(mTranspositionTable.entries()) / double(mTranspositionTable.size()) << "%\n\n";
+
+		std::cout << "Moves sequence :\n";
+
+		for (const Move& move : movesSequence) {
+			std::cout << "   * " << int(move.from()) << " to " << int(move.to()) << "\n";
+		}
+
+		std::cout << "\n\n";
 	}
 
-	std::cout << "\n\n";
 
+	PROFILE_REPORT(std::cerr);
+	ALLOCATIONS_REPORT(std::cerr);
 
 	mTranspositionTable.tick();
+	mPrincipalVariation = movesSequence;
+	mSearching = false;
+
+	stats = mStats;
 
 	return move;
 }
 
-double AI::_evaluate(const Game& game, Player player) const
+// Thread safe : interrupts the running search, which returns its current best move
+void AI::stop()
 {
-	double score(0);
+	mTimeManager.stop();
+}
 
-	// Bishop pair
-	score += .3 * ((popcount(game.piecesOf(player, Bishop)) == 2) - (popcount(game.piecesOf(otherPlayer(player), Bishop)) == 2));
+// Thread safe : the expected reply was played, the ponder search goes on as the real search
+u64 AI::ponderhit()
+{
+	return mTimeManager.ponderhit();
+}
 
-	for (u8 i(0); i < 2; ++i) {
-		double posScore(0);
+// Thread safe : true once the limits of the search are set, until the search returns
+bool AI::isSearching() const
+{
+	return mSearching;
+}
 
-		for (u8 piece(0); piece < 6; ++piece) {
-			u64 bitboard(game.piecesOf(Player(i), PieceType(piece)));
+const std::list<Move>& AI::principalVariation() const
+{
+	return mPrincipalVariation;
+}
 
-			posScore += sPiecesValues[piece] * popcount(game.piecesOf(Player(i), PieceType(piece)));
+// Lines of the last iteration, the best first : as many as the MultiPV setting and the legal moves allow
+const std::vector<IterationStats>& AI::lines() const
+{
+	return mLines;
+}
 
-			while (bitboard) {
-				u8 s = bsfReset(bitboard);
-				u8 f(s % 8), r(s / 8);
+// Evaluation parameters, from White's point of view : the tables of Black are mirrored
+const std::array<double, 6>& AI::piecesValues()
+{
+	return sPiecesValues;
+}
 
-				if (i == White)
-					posScore += mPositionalScore[piece][8*r + f];
-				else
-					posScore += mPositionalScore[piece][8*(7-r) + f];
-			}
-		}
+const std::array<std::array<double, 64>, 6>& AI::positionalScores() const
+{
+	return mPositionalScore;
+}
 
-		score += posScore * (2 * (i == player) - 1);
-	}
+// Evaluation of the tables, also by batches of positions
+const Evaluator& AI::evaluator() const
+{
+	return mEvaluator;
+}
+
+double AI::_evaluate(const Game& game, Player player) const
+{
+	PROFILE_SCOPE(Evaluation);
+
+	double score(0);
+
+	// The accumulator of the game follows the network loaded at the start of the search
+	if (mUsesNetwork && NNUE::instance().isLoaded())
+		score = NNUE::instance().evaluate(game.accumulator(), player) / 100.;
+	else
+		score = playerSign(player) * mEvaluator.evaluate(PackedPosition::pack(game));
 
 	switch (game.status()) {
 	case WhiteWin:
@@ -169,23 +426,118 @@ double AI::_evaluate(const Game& game, Player player) const
 	return score;
 }
 
-// Principal variation search
-std::pair<double, std::list<Move>> AI::_pvs(Game* game, u8 depth, u8 ply, double alpha, double beta, Player player, u64& nodes, bool& interrupted, const std::chrono::steady_clock::time_point& begin, u64 thinkingTime)
+// Static exchange evaluation: material balance of the exchange sequence started by the move on its target square
+double AI::see(const Game& game, const Move& move)
 {
-	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (move.isCastle())
+		return 0;
+
+	std::array<double, 32> gain;
+	u8 d(0), to(move.to());
+
+	Player player(game.activePlayer());
+	PieceType attacker(PieceType(game.pieceType(move.from())));
+
+	u64 occupancy(game.occupancy() & ~(u64(1) << move.from()));
+	u64 bishops(game.pieces(Bishop) | game.pieces(Queen)),
+		rooks(game.pieces(Rook) | game.pieces(Queen));
+
+	if (move.type() == EnPassant) {
+		gain[0] = sPiecesValues[Pawn];
+		occupancy &= ~(u64(1) << (to - 8 * playerSign(player)));
+	} else if (move.isCapture())
+		gain[0] = sPiecesValues[game.pieceType(to)];
+	else
+		gain[0] = 0;
+
+	if (move.isPromotion()) {
+		attacker = move.promotionType();
+		gain[0] += sPiecesValues[attacker] - sPiecesValues[Pawn];
+	}
 
+	u64 attackers(game.attackersTo(to, occupancy) & occupancy);
 
-	// We check time every 8192 nodes
-	if (interrupted || (nodes % 8192 == 0 && std::chrono::duration_cast<std::chrono::milliseconds>(now - begin).count() > thinkingTime)) {
-		interrupted = true;
-		return std::make_pair(-INFINITY, std::list<Move>());
+	while (d < gain.size() - 1) {
+		player = otherPlayer(player);
+
+		// Least valuable attacker of the side to move
+		u8 type(Pawn);
+
+		while (type <= King && !(attackers & game.piecesOf(player, PieceType(type))))
+			++type;
+
+		if (type > King)
+			break;
+
+		u64 candidates(attackers & game.piecesOf(player, PieceType(type)));
+
+		// The king cannot capture a defended piece
+		if (type == King && (attackers & game.player(otherPlayer(player))))
+			break;
+
+		++d;
+		gain[d] = sPiecesValues[attacker] - gain[d - 1];
+
+		// Neither side can improve its score by continuing the exchange
+		if (std::max(-gain[d - 1], gain[d]) < 0)
+			break;
+
+		attacker = PieceType(type);
+		occupancy &= ~(u64(1) << bsfReset(candidates));
+
+		// Sliders hidden behind the attacker join the exchange
+		attackers |= (MoveGenerator::instance().bishopMoves(to, occupancy) & bishops) |
+			         (MoveGenerator::instance().rookMoves(to, occupancy) & rooks);
+		attackers &= occupancy;
 	}
 
+	while (d) {
+		gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+		--d;
+	}
+
+	return gain[0];
+}
+
+// Principal variation search
+std::pair<double, std::list<Move>> AI::_pvs(Game* game, u8 depth, u8 ply, double alpha, double beta, Player player, u64& nodes)
+{
+	if (mTimeManager.shouldStop(nodes))
+		return std::make_pair(-INFINITY, std::list<Move>());
+
+	// The root is searched even if the game is drawn, so that a move is always returned
+	if (depth == 0 || (ply && game->isOver())) {
+		double score(_quiescenceSearch(game, ply, alpha, beta, player, nodes));
+		TRACE_NODE(TraceQuiescenceNode, game->lastMove(), ply, 0, alpha, beta, score, mTimeManager.isStopped() ? TraceInterrupted : 0);
+
+		return std::make_pair(score, std::list<Move>());
+	}
 
 	++nodes;
 
-	if (depth == 0 || game->isOver())
-		return std::make_pair(_quiescenceSearch(game, alpha, beta, player, nodes), std::list<Move>());
+	TRACE_WINDOW(alpha, beta);
+
+#ifdef CHESS_SEARCH_TABLEBASES
+	// Exact result once few pieces are left : a win is worth less than a mate, and more than any material
+	if (ply && mTablebases.canProbe(*game)) {
+		WDLScore wdl;
+		bool isCacheHit(false);
+
+		bool isHit(mTablebases.probeWdl(game, wdl, isCacheHit));
+
+		++mStats.tbProbes;
+		mStats.tbCacheHits += isCacheHit;
+
+		if (isHit) {
+			++mStats.tbHits;
+
+			double score(wdl == WDLWin ? sTablebaseWin - ply : wdl == WDLLoss ? -sTablebaseWin + ply : 0);
+			TRACE_NODE(TracePVSNode, game->lastMove(), ply, depth, traceAlpha, traceBeta, score, 0);
+
+			return std::make_pair(score, std::list<Move>());
+		}
+	}
+#endif
 
 	Move bestMove;
 	double score(-INFINITY);
@@ -201,7 +553,20 @@ std::pair<double, std::list<Move>> AI::_pvs(Game* game, u8 depth, u8 ply, double
 	std::list<Move> possibleMoves(game->possibleMoves());
 	std::list<std::pair<Move, double>> sortedMoves;
 
-	entry = mTranspositionTable.getEnty(game->hash(), isEmpty);
+	// The result only holds for the remaining root moves : it cannot be taken from the table nor stored in it
+	bool isExcluding(!ply && !mExcludedMoves.empty());
+
+	if (isExcluding) {
+		for (const Move& move : mExcludedMoves)
+			possibleMoves.remove(move);
+	}
+
+	{
+		PROFILE_SCOPE(TTProbe);
+		entry = mTranspositionTable.getEnty(game->hash(), isEmpty);
+	}
+
+	++mStats.ttProbes;
 
 	// We matched with an entry in our transposition table
 	if (!isEmpty && game->hash() == entry.hash) {
@@ -209,7 +574,9 @@ std::pair<double, std::list<Move>> AI::_pvs(Game* game, u8 depth, u8 ply, double
 
 		// If the move is not in the possible moves list : collision
 		if (it != possibleMoves.end()) {
-			if (entry.depth >= depth) {
+			++mStats.ttHits;
+
+			if (entry.depth >= depth && !isExcluding) {
 				double entryScore(playerSign(player) * entry.score);
 
 				switch (entry.type) {
@@ -229,6 +596,8 @@ std::pair<double, std::list<Move>> AI::_pvs(Game* game, u8 depth, u8 ply, double
 					movesSequence = entry.movesSequence;
 					score = entryScore;
 					doSearch = false;
+
+					++mStats.ttCutoffs;
 				}
 			}
 
@@ -239,35 +608,60 @@ std::pair<double, std::list<Move>> AI::_pvs(Game* game, u8 depth, u8 ply, double
 		}
 	}
 
+	// Without a hash move, the next line of the previous iteration is searched first
+	if (isExcluding && sortedMoves.empty()) {
+		for (const IterationStats& line : mLines) {
+			std::list<Move>::const_iterator it = std::find(possibleMoves.begin(), possibleMoves.end(), line.principalVariation.front());
+
+			if (it != possibleMoves.end()) {
+				sortedMoves.push_back(std::make_pair(*it, INFINITY));
+				possibleMoves.erase(it);
+				break;
+			}
+		}
+	}
+
 	// Move ordering
-	for (const Move& move : possibleMoves) {
-		double priority(0);
+	{
+		PROFILE_SCOPE(MoveOrdering);
 
-		if (move.isCapture()) {
-			bool hasCapturedLastMovedPiece(false);
-			PieceType capturing, captured;
+		for (const Move& move : possibleMoves) {
+			double priority(0);
 
-			capturing = PieceType(game->pieceType(move.from()));
+			if (move.isCapture()) {
+				double exchange(see(*game, move));
 
-			if (move.type() == EnPassant) {
-				captured = Pawn;
-				hasCapturedLastMovedPiece = true;
-			} else {
-				captured = PieceType(game->pieceType(move.to()));
-				hasCapturedLastMovedPiece = move.to() == game->lastMovedSquare();
-			}
+				// Losing captures are searched after the quiet moves
+				if (exchange < 0) {
+					sortedMoves.push_back(std::make_pair(move, -1000 + exchange));
+					continue;
+				}
 
-			priority += 100 * sPiecesValues[captured] - 10 * sPiecesValues[capturing];
-			priority += 1000 * hasCapturedLastMovedPiece;
-		} else if (move == mKillerMoves[ply][0])
-			priority += 50;
-		else if (move == mKillerMoves[ply][1])
-			priority += 45;
+				bool hasCapturedLastMovedPiece(false);
+				PieceType capturing, captured;
 
-		sortedMoves.push_back(std::make_pair(move, priority));
-	}
+				capturing = PieceType(game->pieceType(move.from()));
+
+				if (move.type() == EnPassant) {
+					captured = Pawn;
+					hasCapturedLastMovedPiece = true;
+				} else {
+					captured = PieceType(game->pieceType(move.to()));
+					hasCapturedLastMovedPiece = move.to() == game->lastMovedSquare();
+				}
+
+				priority += 100 * sPiecesValues[captured] - 10 * sPiecesValues[capturing];
+				priority += 1000 * hasCapturedLastMovedPiece;
+			} else if (move == mKillerMoves[ply][0])
+				priority += 50;
+			else if (move == mKillerMoves[ply][1])
+				priority += 45;
 
-	sortedMoves.sort([](const std::pair<Move, double>& p1, const std::pair<Move, double>& p2) { return p1.second > p2.second; });
+			sortedMoves.push_back(std::make_pair(move, priority));
+		}
+
+		sortedMoves.sort([](const std::pair<Move, double>& p1, const std::pair<Move, double>& p2) { return p1.second > p2.second; });
+	}
 		
 
 	// Search
@@ -284,14 +678,14 @@ std::pair<double, std::list<Move>> AI::_pvs(Game* game, u8 depth, u8 ply, double
 			game->makeMove(move.first);
 
 			if (isFirstMove) {
-				pair = _pvs(game, depth - 1, ply + 1, -beta, -alpha, otherPlayer(player), nodes, interrupted, begin, thinkingTime);
+				pair = _pvs(game, depth - 1, ply + 1, -beta, -alpha, otherPlayer(player), nodes);
 				value = -pair.first;
 			} else {
-				pair = _pvs(game, depth - 1, ply + 1, -alpha - 1, -alpha, otherPlayer(player), nodes, interrupted, begin, thinkingTime);
+				pair = _pvs(game, depth - 1, ply + 1, -alpha - 1, -alpha, otherPlayer(player), nodes);
 				value = -pair.first;
 
 				if (alpha < value && value < beta) {
-					pair = _pvs(game, depth - 1, ply + 1, -beta, -alpha, otherPlayer(player), nodes, interrupted, begin, thinkingTime);
+					pair = _pvs(game, depth - 1, ply + 1, -beta, -alpha, otherPlayer(player), nodes);
 					value = -pair.first;
 				}
 			}
@@ -299,7 +693,9 @@ std::pair<double, std::list<Move>> AI::_pvs(Game* game, u8 depth, u8 ply, double
 
 			game->unmakeMove();
 
-
+			// The result of an interrupted subtree cannot be trusted
+			if (mTimeManager.isStopped())
+				break;
 
 			if (value > score) {
 				score = value;
@@ -317,6 +713,9 @@ std::pair<double, std::list<Move>> AI::_pvs(Game* game, u8 depth, u8 ply, double
 							mKillerMoves[ply][0] = move.first;
 						}
 
+						++mStats.betaCutoffs;
+						mStats.firstMoveCutoffs += isFirstMove;
+
 						type = CutNode;
 						break;
 					}
@@ -327,35 +726,76 @@ std::pair<double, std::list<Move>> AI::_pvs(Game* game, u8 depth, u8 ply, double
 		}
 
 		movesSequence.push_front(bestMove);
-		mTranspositionTable.addEntry(Entry(game->hash(), type, bestMove, movesSequence, depth, playerSign(player) * score, false));
+
+		if (!mTimeManager.isStopped() && !isExcluding)
+			mTranspositionTable.addEntry(Entry(game->hash(), type, bestMove, movesSequence, depth, playerSign(player) * score, false));
 	}
 
+	TRACE_NODE(TracePVSNode, game->lastMove(), ply, depth, traceAlpha, traceBeta, score,
+		(!isEmpty && game->hash() == entry.hash ? TraceHashHit : 0) | (doSearch ? 0 : TraceHashCutoff) | (mTimeManager.isStopped() ? TraceInterrupted : 0));
+
 	return std::make_pair(score, movesSequence);
 }
 
-double AI::_quiescenceSearch(Game* game, double alpha, double beta, Player player, u64& nodes)
+double AI::_quiescenceSearch(Game* game, u8 ply, double alpha, double beta, Player player, u64& nodes)
 {
+	// Checked at every node, so that a node limit is exact
+	if (mTimeManager.shouldStop(nodes))
+		return alpha;
+
+	++nodes;
+	++mStats.qnodes;
+
 	double standPat(_evaluate(*game, player));
 
 	if (game->isOver())
 		return standPat;
 
-	if (standPat >= beta)
+	if (standPat >= beta) {
+		++mStats.standPatCutoffs;
 		return beta;
+	}
 
 	if (alpha < standPat)
 		alpha = standPat;
 
 	double v(0);
 
-	for (const Move& move : game->possibleMoves()) {
-		if (!move.isCapture())
-			break;
+	std::list<std::pair<Move, double>> captures;
+
+	{
+		PROFILE_SCOPE(MoveOrdering);
+
+		for (const Move& move : game->possibleMoves()) {
+			if (!move.isCapture())
+				continue;
+
+			double exchange(see(*game, move));
+
+			// A capture losing material cannot raise alpha over the stand pat
+			if (exchange < 0) {
+				++mStats.seePrunings;
+				continue;
+			}
+
+			captures.push_back(std::make_pair(move, exchange));
+		}
+
+		captures.sort([](const std::pair<Move, double>& p1, const std::pair<Move, double>& p2) { return p1.second > p2.second; });
+	}
+
+	for (const std::pair<Move, double>& capture : captures) {
+		const Move& move(capture.first);
 
 		game->makeMove(move);
-		v = -_quiescenceSearch(game, -beta, -alpha, otherPlayer(player), nodes);
+		v = -_quiescenceSearch(game, ply + 1, -beta, -alpha, otherPlayer(player), nodes);
 		game->unmakeMove();
 
+		TRACE_NODE(TraceQuiescenceNode, move, ply + 1, 0, -beta, -alpha, -v, mTimeManager.isStopped() ? TraceInterrupted : 0);
+
+		if (mTimeManager.isStopped())
+			return alpha;
+
 		if (v >= beta)
 			return beta;
 
@@ -363,7 +803,5 @@ double AI::_quiescenceSearch(Game* game, double alpha, double beta, Player playe
 			alpha = v;
 	}
 
-	++nodes;
-
 	return alpha;
 }
@@ -3,25 +3,84 @@
 
 #include "Game.h"
 #include "TranspositionTable.h"
+#include "TimeManager.h"
+#include "SearchStats.h"
+#include "SearchTrace.h"
+#include "PolyglotBook.h"
+#include "PositionDatabase.h"
+#include "Tablebases.h"
+#include "Evaluator.h"
 
 class AI
 {
 public:
 	AI(size_t);
 
+	void setVerbose(bool);
+	void setUsesNetwork(bool);
+	void setMultiPV(u8);
+	void setInfoCallback(const std::function<void(const IterationStats&)>&);
+
+	void clear();
+	void resizeTranspositionTable(size_t);
+
+	bool openBook(const std::string&);
+	void closeBook();
+
+	bool openDatabase(const std::string&);
+	void closeDatabase();
+
+	bool setTablebasesPath(const std::string&);
+
 	Move bestMove(const Game&, u64);
+	Move bestMove(const Game&, const SearchLimits&);
+	Move bestMove(const Game&, const SearchLimits&, SearchStats&);
+
+	void stop();
+	u64 ponderhit();
+
+	bool isSearching() const;
+
+	const std::list<Move>& principalVariation() const;
+	const std::vector<IterationStats>& lines() const;
+
+	static const std::array<double, 6>& piecesValues();
+	static double see(const Game&, const Move&);
+	const std::array<std::array<double, 64>, 6>& positionalScores() const;
+	const Evaluator& evaluator() const;
 
 private:
 	static std::array<double, 6> sPiecesValues;
+	static const u8 sMaxDepth;
+	static const double sTablebaseWin;
 
 	double _evaluate(const Game&, Player) const;
-	std::pair<double, std::list<Move>> _pvs(Game*, u8, u8, double, double, Player, u64&, bool&, const std::chrono::steady_clock::time_point&, u64 duration);
-	double _quiescenceSearch(Game*, double, double, Player, u64&);
+	std::pair<double, std::list<Move>> _pvs(Game*, u8, u8, double, double, Player, u64&);
+	double _quiescenceSearch(Game*, u8, double, double, Player, u64&);
 
 	TranspositionTable mTranspositionTable;
+	TimeManager mTimeManager;
+	std::list<Move> mPrincipalVariation;
+	std::vector<IterationStats> mLines;
+	SearchStats mStats;
+	PolyglotBook mBook;
+	PositionDatabase mDatabase;
+	Tablebases mTablebases;
+
+	std::atomic<bool> mSearching;
+
+	bool mVerbose;
+	bool mUsesNetwork;
+	std::function<void(const IterationStats&)> mInfoCallback;
+
 	std::vector<std::array<Move, 2>> mKillerMoves;
 
+	// Best moves of the previous lines of the iteration, not searched at the root
+	u8 mMultiPV;
+	std::vector<Move> mExcludedMoves;
+
 	std::array<std::array<double, 64>, 6> mPositionalScore;
+	Evaluator mEvaluator;
 };
 
 #endif // AI_H
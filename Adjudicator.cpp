@@ -0,0 +1,50 @@
+#include "Adjudicator.h"
+
+Adjudicator::Adjudicator(double resignScore, u16 resignPlies, double drawScore, u16 drawPlies, u16 drawMinPlies, u16 maxPlies) :
+	mResignScore(resignScore),
+	mResignPlies(resignPlies),
+	mDrawScore(drawScore),
+	mDrawPlies(drawPlies),
+	mDrawMinPlies(drawMinPlies),
+	mMaxPlies(maxPlies),
+	mResignCount(0),
+	mDrawCount(0),
+	mLastScore(0)
+{
+}
+
+// False only if neither side can ever mate : no pawn, rook or queen, and at most one minor piece
+bool Adjudicator::hasMatingMaterial(const Game& game)
+{
+	if (game.pieces(Pawn) || game.pieces(Rook) || game.pieces(Queen))
+		return true;
+
+	return popcount(game.pieces(Knight) | game.pieces(Bishop)) > 1;
+}
+
+// Before the move of the given ply
+bool Adjudicator::isDrawn(const Game& game, u16 ply) const
+{
+	return ply >= mMaxPlies || !hasMatingMaterial(game);
+}
+
+// After the move of the given ply, with the score of its search : the adjudicated result, or Ongoing
+Status Adjudicator::update(u16 ply, double score)
+{
+	// Both sides agree that the game is decided
+	if (std::abs(score) >= mResignScore && (mResignCount == 0 || (score > 0) == (mLastScore > 0)))
+		++mResignCount;
+	else
+		mResignCount = std::abs(score) >= mResignScore;
+
+	mDrawCount = mDrawPlies && ply >= mDrawMinPlies && std::abs(score) <= mDrawScore ? mDrawCount + 1 : 0;
+	mLastScore = score;
+
+	if (mResignCount >= mResignPlies)
+		return score > 0 ? WhiteWin : BlackWin;
+
+	if (mDrawPlies && mDrawCount >= mDrawPlies)
+		return Draw;
+
+	return Ongoing;
+}
@@ -0,0 +1,34 @@
+#ifndef ADJUDICATOR_H
+#define ADJUDICATOR_H
+
+#include "Game.h"
+
+// Adjudication of engine games on the scores of their searches, shared by the match runner and the data generator.
+// Scores are in pawns from White's point of view, counts in plies.
+class Adjudicator
+{
+public:
+	// A side resigns after resignPlies plies in a row scored beyond resignScore for its opponent. The game is drawn
+	// after drawPlies plies in a row within drawScore once drawMinPlies plies are played (never with 0 drawPlies),
+	// or at maxPlies.
+	Adjudicator(double resignScore, u16 resignPlies, double drawScore, u16 drawPlies, u16 drawMinPlies, u16 maxPlies);
+
+	static bool hasMatingMaterial(const Game&);
+
+	bool isDrawn(const Game&, u16) const;
+	Status update(u16, double);
+
+private:
+	double mResignScore;
+	u16 mResignPlies;
+	double mDrawScore;
+	u16 mDrawPlies;
+	u16 mDrawMinPlies;
+	u16 mMaxPlies;
+
+	u16 mResignCount;
+	u16 mDrawCount;
+	double mLastScore;
+};
+
+#endif // ADJUDICATOR_H
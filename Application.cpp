@@ -13,6 +13,9 @@ void Application::go(Player humanPlayer, u64 thinkingTime)
 
 	AI ai(1 << 22);
 
+	// Optional opening book, next to the executable
+	ai.openBook("book.bin");
+
 	bool isMoving(false), promoSelection(false), hasMoved(false);
 	std::string lastMoveStr;
 
@@ -69,8 +72,24 @@ void Application::go(Player humanPlayer, u64 thinkingTime)
 
 
 	mWindow.create(sf::VideoMode(8 * mTileSize, 8 * mTileSize), "Chess");
+	mWindow.setFramerateLimit(60);
 	std::cout << "\n\n";
 
+	// The AI thinks on a worker thread so that the window keeps being drawn and polled
+	std::future<Move> search;
+
+	// While the human thinks, the AI ponders on the position after the expected reply
+	Move ponderMove, playedMove;
+	bool isPondering(false), isPonderHit(false);
+	u32 ponderHits(0), ponderMisses(0);
+	u64 ponderGain(0);
+
+	// The limits must be set before a stop can be handled, or the search would clear it and run its full time
+	auto waitSearchStart([&]() {
+		while (!ai.isSearching() && search.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			std::this_thread::yield();
+	});
+
 
 	while (mWindow.isOpen() && !game.isOver()) {
 		sf::Event event;
@@ -79,10 +98,60 @@ void Application::go(Player humanPlayer, u64 thinkingTime)
 		hoveredSquare = (7 - (sf::Mouse::getPosition(mWindow).y / mTileSize)) * 8 + (sf::Mouse::getPosition(mWindow).x / mTileSize);;
 
 		if (game.activePlayer() != humanPlayer) {
-			Move bestMove(ai.bestMove(game, thinkingTime));
-			
-			game.makeMove(bestMove);
-			hasMoved = true;
+			if (!search.valid()) {
+				search = std::async(std::launch::async, [&ai, thinkingTime](Game root) { return ai.bestMove(root, thinkingTime); }, game);
+				waitSearchStart();
+			} else {
+				// Repeated until the search ends, in case the ponder hit came before the search started
+				if (isPonderHit)
+					ai.ponderhit();
+
+				if (search.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+					game.makeMove(search.get());
+					hasMoved = true;
+
+					if (isPonderHit) {
+						ponderGain += ai.ponderhit();
+						isPonderHit = false;
+					}
+
+					// Ponder on the reply expected by the principal variation
+					if (ai.principalVariation().size() >= 2 && !game.isOver()) {
+						ponderMove = *std::next(ai.principalVariation().begin());
+
+						if (std::find(game.possibleMoves().begin(), game.possibleMoves().end(), ponderMove) != game.possibleMoves().end()) {
+							SearchLimits limits;
+							limits.moveTime = thinkingTime;
+							limits.ponder = true;
+
+							Game ponderGame(game);
+							ponderGame.makeMove(ponderMove);
+
+							if (!ponderGame.isOver()) {
+								search = std::async(std::launch::async, [&ai, limits](Game root) { return ai.bestMove(root, limits); }, ponderGame);
+								waitSearchStart();
+								isPondering = true;
+							}
+						}
+					}
+				}
+			}
+
+			while (mWindow.pollEvent(event)) {
+				switch (event.type) {
+				case sf::Event::Closed:
+					ai.stop();
+					mWindow.close();
+					break;
+
+				case sf::Event::KeyPressed:
+					// Space interrupts the search : the AI plays the best move found so far
+					if (event.key.code == sf::Keyboard::Space)
+						ai.stop();
+
+					break;
+				}
+			}
 		} else {
 			while (mWindow.pollEvent(event)) {
 				u8 s = (7 - (event.mouseButton.y / mTileSize)) * 8 + (event.mouseButton.x / mTileSize);
@@ -102,6 +171,7 @@ void Application::go(Player humanPlayer, u64 thinkingTime)
 									PieceType t(promoPiece[i]);
 									std::list<Move>::const_iterator it = std::find_if(moves.begin(), moves.end(), [t](const Move& m) { return m.promotionType() == t; });
 
+									playedMove = *it;
 									game.makeMove(*it);
 									promoSelection = false;
 									moves.clear();
@@ -144,6 +214,7 @@ void Application::go(Player humanPlayer, u64 thinkingTime)
 						} else {
 							moves.clear();
 
+							playedMove = *it;
 							game.makeMove(*it);
 							hasMoved = true;
 						}
@@ -155,6 +226,24 @@ void Application::go(Player humanPlayer, u64 thinkingTime)
 					break;
 				}
 			}
+
+			if (hasMoved && isPondering) {
+				isPondering = false;
+
+				if (playedMove == ponderMove) {
+					// The ponder search goes on as the real search, with its depth and transposition table
+					ai.ponderhit();
+					isPonderHit = true;
+					++ponderHits;
+				} else {
+					// The search restarts on the actual position, the transposition table stays warm
+					while (search.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready)
+						ai.stop();
+
+					search.get();
+					++ponderMisses;
+				}
+			}
 		}
 
 		mWindow.clear();
@@ -225,6 +314,10 @@ void Application::go(Player humanPlayer, u64 thinkingTime)
 	}
 
 
+	// The search may have been started before the stop request reached it
+	while (search.valid() && search.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready)
+		ai.stop();
+
 	std::cout << "\n\n";
 
 	switch (game.status())
@@ -244,6 +337,15 @@ void Application::go(Player humanPlayer, u64 thinkingTime)
 
 	std::cout << "\n\n";
 
+	if (ponderHits + ponderMisses) {
+		std::cout << "Ponder hit rate : " << 100 * ponderHits / (ponderHits + ponderMisses) << "% (" << ponderHits << "/" << ponderHits + ponderMisses << ")\n";
+
+		if (ponderHits)
+			std::cout << "Think time gained : " << ponderGain / ponderHits << " ms per hit (+" << 100 * ponderGain / (ponderHits * thinkingTime) << "% of the thinking time)\n";
+
+		std::cout << "\n";
+	}
+
 	gameOverSound.play();
 
 	
@@ -4,6 +4,9 @@
 #include "AI.h"
 #include "Hashing.h"
 
+#include <SFML\Graphics.hpp>
+#include <SFML\Audio.hpp>
+
 class Application
 {
 public:
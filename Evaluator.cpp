@@ -0,0 +1,147 @@
+#include "Evaluator.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+const size_t Evaluator::sBatchSize = 16;
+
+const u16 Evaluator::sBlackOffset = 384;
+const int Evaluator::sBishopPair = 30;
+
+PackedPosition PackedPosition::pack(const Game& game)
+{
+	PackedPosition position;
+
+	position.players = { game.player(White), game.player(Black) };
+
+	for (u8 type(0); type < 6; ++type)
+		position.pieces[type] = game.pieces(PieceType(type));
+
+	return position;
+}
+
+u64 PackedPosition::piecesOf(Player player, PieceType type) const
+{
+	return players[player] & pieces[type];
+}
+
+Evaluator::Evaluator()
+{
+	mTable.fill(0);
+
+	for (std::array<int, 16>& scores : mSquareScores)
+		scores.fill(0);
+}
+
+void Evaluator::setParameters(const std::array<double, 6>& values, const std::array<std::array<double, 64>, 6>& positionalScores)
+{
+	mTable.fill(0);
+
+	for (u8 type(0); type < 6; ++type) {
+		for (u8 square(0); square < 64; ++square) {
+			int score(int(std::lround(100 * (values[type] + positionalScores[type][square]))));
+
+			mTable[_index(square, PieceType(type), White)] = score;
+			mTable[_index(square ^ 56, PieceType(type), Black)] = -score;
+		}
+	}
+
+	for (u8 square(0); square < 64; ++square) {
+		for (u8 player(0); player < 2; ++player)
+			for (u8 type(0); type < 6; ++type)
+				mSquareScores[square][1 + 6 * player + type] = mTable[_index(square, PieceType(type), Player(player))];
+	}
+}
+
+// From White's point of view, in pawns
+double Evaluator::evaluate(const PackedPosition& position) const
+{
+	int score(sBishopPair * ((popcount(position.piecesOf(White, Bishop)) == 2) - (popcount(position.piecesOf(Black, Bishop)) == 2)));
+
+	for (u8 player(0); player < 2; ++player) {
+		for (u8 type(0); type < 6; ++type) {
+			u64 pieces(position.piecesOf(Player(player), PieceType(type)));
+
+			while (pieces)
+				score += mTable[_index(bsfReset(pieces), PieceType(type), Player(player))];
+		}
+	}
+
+	return score / 100.;
+}
+
+// The positions are transposed by groups of 16 into a board of piece codes per square, one byte per position :
+// 0 for an empty square, 1 + type for White pieces, 7 + type for Black pieces. The scores of the codes on a square
+// are then looked up for 8 positions at once, with two permutations of 8 scores blended on the fourth bit of the code.
+void Evaluator::evaluate(const PackedPosition* positions, size_t count, double* scores) const
+{
+	alignas(32) std::array<std::array<u8, 16>, 64> board;
+	alignas(32) std::array<int, 16> sums;
+
+	for (size_t begin(0); begin < count; begin += sBatchSize) {
+		size_t size(std::min(sBatchSize, count - begin));
+
+		for (std::array<u8, 16>& square : board)
+			square.fill(0);
+
+		sums.fill(0);
+
+		for (size_t i(0); i < size; ++i) {
+			const PackedPosition& position(positions[begin + i]);
+
+			sums[i] = sBishopPair * ((popcount(position.piecesOf(White, Bishop)) == 2) - (popcount(position.piecesOf(Black, Bishop)) == 2));
+
+			for (u8 player(0); player < 2; ++player) {
+				for (u8 type(0); type < 6; ++type) {
+					u64 pieces(position.piecesOf(Player(player), PieceType(type)));
+
+					while (pieces)
+						board[bsfReset(pieces)][i] = 1 + 6 * player + type;
+				}
+			}
+		}
+
+#if defined(__AVX2__)
+		__m256i low(_mm256_load_si256(reinterpret_cast<const __m256i*>(&sums[0])));
+		__m256i high(_mm256_load_si256(reinterpret_cast<const __m256i*>(&sums[8])));
+
+		for (u8 square(0); square < 64; ++square) {
+			__m256i first(_mm256_load_si256(reinterpret_cast<const __m256i*>(&mSquareScores[square][0])));
+			__m256i second(_mm256_load_si256(reinterpret_cast<const __m256i*>(&mSquareScores[square][8])));
+
+			for (size_t half(0); half < 2; ++half) {
+				__m256i codes(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&board[square][8 * half]))));
+				__m256 selector(_mm256_castsi256_ps(_mm256_slli_epi32(codes, 28)));
+
+				__m256i score(_mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(_mm256_permutevar8x32_epi32(first, codes)),
+				                                                    _mm256_castsi256_ps(_mm256_permutevar8x32_epi32(second, codes)), selector)));
+
+				if (half)
+					high = _mm256_add_epi32(high, score);
+				else
+					low = _mm256_add_epi32(low, score);
+			}
+		}
+
+		_mm256_store_si256(reinterpret_cast<__m256i*>(&sums[0]), low);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(&sums[8]), high);
+#else
+		for (u8 square(0); square < 64; ++square)
+			for (size_t i(0); i < 16; ++i)
+				sums[i] += mSquareScores[square][board[square][i]];
+#endif
+
+		for (size_t i(0); i < size; ++i)
+			scores[begin + i] = sums[i] / 100.;
+	}
+}
+
+// Black squares are mirrored, so that both players read the tables from their own side
+u16 Evaluator::_index(u8 square, PieceType type, Player player)
+{
+	if (player == White)
+		return 64 * type + square;
+
+	return sBlackOffset + 64 * type + (square ^ 56);
+}
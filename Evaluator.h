@@ -0,0 +1,44 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include "Game.h"
+
+// Compact position for the batch evaluation : only the bitboards
+struct PackedPosition
+{
+	static PackedPosition pack(const Game&);
+
+	u64 piecesOf(Player, PieceType) const;
+
+	std::array<u64, 2> players;
+	std::array<u64, 6> pieces;
+};
+
+// Material, piece-square tables and bishop pair, in integer centipawns so that the order of the additions does
+// not matter : the batch kernels give exactly the scores of the scalar evaluation.
+class Evaluator
+{
+public:
+	Evaluator();
+
+	void setParameters(const std::array<double, 6>&, const std::array<std::array<double, 64>, 6>&);
+
+	double evaluate(const PackedPosition&) const;
+	void evaluate(const PackedPosition*, size_t, double*) const;
+
+	static const size_t sBatchSize;
+
+private:
+	static const u16 sBlackOffset;
+	static const int sBishopPair;
+
+	static u16 _index(u8, PieceType, Player);
+
+	// Value and positional score of each piece on each square as seen by White, Black pieces negated
+	std::array<int, 768> mTable;
+
+	// The same scores by square, indexed by the piece codes of the batch evaluation
+	alignas(32) std::array<std::array<int, 16>, 64> mSquareScores;
+};
+
+#endif // EVALUATOR_H
@@ -9,13 +9,20 @@ std::array<u8, 2> Game::sCastleShift = { 0, 2 };
 std::array<u8, 2> Game::sCastleRookFrom = { 7, 0 };
 std::array<u8, 2> Game::sCastleRookTo = { 5, 3 };
 
+// Flags of PositionState::computed
+static const u8 sCheckersComputed = 1;
+static const u8 sAttacksComputed = 2; // Shifted by the player
+static const u8 sStatusComputed = 8;
+static const u8 sMovesGenerated = 16;
+
 Game::Game() :
 	mActivePlayer(White),
 	mHalfmoveClock(0),
 	mEnPassantSquare(-1),
 	mLastMovedPieceSquare(-1),
 	mCastlingRights(WhiteKingCastle | WhiteQueenCastle | BlackKingCastle | BlackQueenCastle),
-	mStatus(Ongoing)
+	mNetwork(nullptr),
+	mAccumulator()
 {
 	// Init bitboards
 
@@ -51,10 +58,91 @@ Game::Game() :
 		}
 	}
 
-	_generateMoves();
+	mMoves.push(std::list<Move>());
+	mStates.push_back(PositionState());
 
-	mHashs.push(0);
+	mHashs.push(computeHash());
 	mHashsVisits[mHashs.top()] += 1;
+
+	refreshAccumulator();
+}
+
+// Forsyth-Edwards Notation, the fullmove number is ignored
+Game::Game(const std::string& fen) :
+	mOccupancy(0),
+	mActivePlayer(White),
+	mHalfmoveClock(0),
+	mEnPassantSquare(-1),
+	mLastMovedPieceSquare(-1),
+	mCastlingRights(0),
+	mNetwork(nullptr),
+	mAccumulator()
+{
+	std::istringstream stream(fen);
+	std::string placement, activePlayer("w"), castlingRights("-"), enPassant("-");
+	int halfmoveClock(0);
+
+	stream >> placement >> activePlayer >> castlingRights >> enPassant >> halfmoveClock;
+
+	mPlayers.fill(0);
+	mPieces.fill(0);
+	mPieceTypes.fill(-1);
+
+
+	// Piece placement, from the 8th rank to the 1st
+	int square(56);
+
+	for (char c : placement) {
+		if (c == '/')
+			square -= 16;
+		else if (c >= '1' && c <= '8')
+			square += c - '0';
+		else {
+			size_t type(std::string("pnbrqk").find(char(tolower(c))));
+
+			if (type == std::string::npos || square < 0 || square > 63)
+				throw std::runtime_error("invalid FEN : " + fen);
+
+			_addPiece(square, PieceType(type), isupper(c) ? White : Black);
+			++square;
+		}
+	}
+
+	if (popcount(piecesOf(White, King)) != 1 || popcount(piecesOf(Black, King)) != 1 || (activePlayer != "w" && activePlayer != "b"))
+		throw std::runtime_error("invalid FEN : " + fen);
+
+	_refreshKingSquare(White);
+	_refreshKingSquare(Black);
+
+	mActivePlayer = activePlayer == "w" ? White : Black;
+	mHalfmoveClock = std::min(std::max(halfmoveClock, 0), 100);
+
+
+	// Castling rights are only kept if the king and the rook are on their initial squares
+	for (char c : castlingRights) {
+		size_t i(std::string("KQkq").find(c));
+
+		if (i == std::string::npos)
+			continue;
+
+		Player player(Player(i / 2));
+		u8 rookSquare(sCastleDelta[player] + (i % 2 ? 0 : 7));
+
+		if (mKings[player] == sCastleDelta[player] + 4 && (piecesOf(player, Rook) & (u64(1) << rookSquare)))
+			mCastlingRights |= WhiteKingCastle << i;
+	}
+
+	if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' && (enPassant[1] == '3' || enPassant[1] == '6'))
+		mEnPassantSquare = 8 * (enPassant[1] - '1') + enPassant[0] - 'a';
+
+
+	mMoves.push(std::list<Move>());
+	mStates.push_back(PositionState());
+
+	mHashs.push(computeHash());
+	mHashsVisits[mHashs.top()] += 1;
+
+	refreshAccumulator();
 }
 
 Game::Game(const Game& game) :
@@ -66,11 +154,14 @@ Game::Game(const Game& game) :
 	mActivePlayer(game.mActivePlayer),
 	mHalfmoveClock(game.mHalfmoveClock),
 	mEnPassantSquare(game.mEnPassantSquare),
+	mLastMovedPieceSquare(game.mLastMovedPieceSquare),
 	mCastlingRights(game.mCastlingRights),
-	mStatus(game.mStatus)
+	mNetwork(game.mNetwork),
+	mAccumulator(game.mAccumulator)
 {
-	mMoves.push(game.possibleMoves());
+	mMoves.push(game.mMoves.top());
 	mHashs.push(game.hash());
+	mStates.push_back(game.mStates.back());
 }
 
 Game::~Game()
@@ -118,6 +209,11 @@ u8 Game::castlingRights() const
 	return mCastlingRights;
 }
 
+u8 Game::halfmoveClock() const
+{
+	return mHalfmoveClock;
+}
+
 u8 Game::enPassantSquare() const
 {
 	return mEnPassantSquare;
@@ -128,19 +224,156 @@ u8 Game::lastMovedSquare() const
 	return mLastMovedPieceSquare;
 }
 
+Move Game::lastMove() const
+{
+	return mHistory.empty() ? Move() : mHistory.back().move;
+}
+
 u64 Game::hash() const
 {
 	return mHashs.top();
 }
 
+// Full computation of the Zobrist key, which is otherwise updated incrementally by the moves
+u64 Game::computeHash() const
+{
+	u64 hash(Hashing::hashCastlingRights(mCastlingRights));
+
+	if (mActivePlayer == Black)
+		hash ^= Hashing::hashTurn();
+
+	if (mEnPassantSquare != u8(-1))
+		hash ^= Hashing::hashEnPassantFile(mEnPassantSquare % 8);
+
+	for (u8 square(0); square < 64; ++square) {
+		if (mPieceTypes[square] != u8(-1))
+			hash ^= Hashing::hashPiece(square, PieceType(mPieceTypes[square]), Player(bool(mPlayers[Black] & (u64(1) << square))));
+	}
+
+	return hash;
+}
+
+const Accumulator& Game::accumulator() const
+{
+	return mAccumulator;
+}
+
+// Full computation of the first layer of the loaded network, which is otherwise updated incrementally by the moves
+Accumulator Game::computeAccumulator() const
+{
+	const NNUE& network(NNUE::instance());
+	Accumulator accumulator;
+
+	network.reset(accumulator);
+
+	for (u8 square(0); square < 64; ++square) {
+		if (mPieceTypes[square] != u8(-1))
+			network.addFeature(accumulator, square, PieceType(mPieceTypes[square]), Player(bool(mPlayers[Black] & (u64(1) << square))));
+	}
+
+	return accumulator;
+}
+
+// Follows the network currently loaded, to be called before evaluating a game created before its loading
+void Game::refreshAccumulator()
+{
+	mNetwork = NNUE::instance().isLoaded() ? &NNUE::instance() : nullptr;
+
+	if (mNetwork)
+		mAccumulator = computeAccumulator();
+}
+
+// Generated on first use
 const std::list<Move>& Game::possibleMoves() const
 {
+	if (!(mStates.back().computed & sMovesGenerated))
+		_generateMoves();
+
 	return mMoves.top();
 }
 
+// Stops at the first legal move found, without generating the moves list
+bool Game::hasLegalMoves() const
+{
+	if (mStates.back().computed & sMovesGenerated)
+		return !mMoves.top().empty();
+
+	const MoveGenerator& generator(MoveGenerator::instance());
+	Player by(otherPlayer(mActivePlayer));
+	u8 king(mKings[mActivePlayer]);
+
+	// A castle is only legal if the king can also step on the square next to it
+	if (generator.kingMoves(king) & ~mPlayers[mActivePlayer] & ~attacks(by))
+		return true;
+
+	u64 checkers(this->checkers()), targets(~mPlayers[mActivePlayer]);
+
+	if (checkers & (checkers - 1))
+		return false;
+
+	if (checkers) {
+		u64 checker(checkers);
+		targets = checkers | generator.between(king, bsfReset(checker));
+	}
+
+	// A pinned knight cannot move
+	for (u64 knights(piecesOf(mActivePlayer, Knight) & ~pinned()); knights;) {
+		if (generator.knightMoves(bsfReset(knights)) & targets)
+			return true;
+	}
+
+	for (u64 pieces(mPlayers[mActivePlayer] & ~(mPieces[Pawn] | mPieces[Knight] | mPieces[King])); pieces;) {
+		u8 square(bsfReset(pieces));
+		u64 moves(0);
+
+		switch (mPieceTypes[square]) {
+		case Bishop:
+			moves = generator.bishopMoves(square, mOccupancy);
+			break;
+
+		case Rook:
+			moves = generator.rookMoves(square, mOccupancy);
+			break;
+
+		default:
+			moves = generator.queenMoves(square, mOccupancy);
+		}
+
+		if (pinned() & (u64(1) << square))
+			moves &= generator.line(king, square);
+
+		if (moves & targets)
+			return true;
+	}
+
+	for (u64 pawns(piecesOf(mActivePlayer, Pawn)); pawns;) {
+		u8 square(bsfReset(pawns));
+		u64 push(u64(1) << (square + sPawnShift[mActivePlayer]) & ~mOccupancy), moves(push | (generator.pawnAttacks(square, mActivePlayer) & mPlayers[by]));
+
+		if (push & sDoublePushMask[mActivePlayer])
+			moves |= circularShift(push, sPawnShift[mActivePlayer]) & ~mOccupancy;
+
+		if (pinned() & (u64(1) << square))
+			moves &= generator.line(king, square);
+
+		if (moves & targets)
+			return true;
+
+		if (mEnPassantSquare != u8(-1) && (generator.pawnAttacks(square, mActivePlayer) & (u64(1) << mEnPassantSquare)) &&
+			_isLegal(Move(square, mEnPassantSquare, EnPassant)))
+			return true;
+	}
+
+	return false;
+}
+
+// Computed on first use
 Status Game::status() const
 {
-	return mStatus;
+	if (!(mStates.back().computed & sStatusComputed))
+		_computeStatus();
+
+	return mStates.back().status;
 }
 
 bool Game::isOver() const
@@ -150,31 +383,60 @@ bool Game::isOver() const
 
 bool Game::isKingInCheck(Player player) const
 {
-	return _isAttacked(mKings[player], player);
+	if (player == mActivePlayer)
+		return checkers();
+
+	return attacks(mActivePlayer) & piecesOf(player, King);
 }
 
-void Game::makeMove(const Move& move)
+u64 Game::checkers() const
 {
-	if (std::find(mMoves.top().begin(), mMoves.top().end(), move) == mMoves.top().end())
-		return;
+	if (!(mStates.back().computed & sCheckersComputed))
+		_computeCheckers();
 
-	mHashs.push(hash() ^ _makeMove(move));
-	mHashsVisits[mHashs.top()] += 1;
+	return mStates.back().checkers;
+}
 
-	_generateMoves();
+u64 Game::pinned() const
+{
+	if (!(mStates.back().computed & sCheckersComputed))
+		_computeCheckers();
 
+	return mStates.back().pinned;
+}
 
-	// If no moves are available, then the game is over
-	if (!mMoves.top().size()) {
-		if (isKingInCheck(mActivePlayer))
-			mStatus = Status(1 - mActivePlayer); // Checkmate
-		else
-			mStatus = Draw; // Stalemate
-	}
+u64 Game::attacks(Player player) const
+{
+	if (!(mStates.back().computed & (sAttacksComputed << player)))
+		_computeAttacks(player);
 
-	// Fifty-move rule or threefold repetition
-	if (mHalfmoveClock == 100 || mHashsVisits[mHashs.top()] == 3)
-		mStatus = Draw;
+	return mStates.back().attacks[player];
+}
+
+// Pieces of both players attacking the square, given the occupancy (sliders see through removed pieces)
+u64 Game::attackersTo(u8 square, u64 occupancy) const
+{
+	return (MoveGenerator::instance().rookMoves(square, occupancy) & (mPieces[Rook] | mPieces[Queen])) |
+		   (MoveGenerator::instance().bishopMoves(square, occupancy) & (mPieces[Bishop] | mPieces[Queen])) |
+		   (MoveGenerator::instance().knightMoves(square) & mPieces[Knight]) |
+		   (MoveGenerator::instance().kingMoves(square) & mPieces[King]) |
+		   (MoveGenerator::instance().pawnAttacks(square, Black) & piecesOf(White, Pawn)) |
+		   (MoveGenerator::instance().pawnAttacks(square, White) & piecesOf(Black, Pawn));
+}
+
+void Game::makeMove(const Move& move)
+{
+	const std::list<Move>& moves(possibleMoves());
+
+	if (std::find(moves.begin(), moves.end(), move) == moves.end())
+		return;
+
+	TRACK_ALLOCATIONS(History);
+
+	mHashs.push(hash() ^ _makeMove(move));
+	mHashsVisits[mHashs.top()] += 1;
+	mMoves.push(std::list<Move>());
+	mStates.push_back(PositionState());
 }
 
 void Game::unmakeMove()
@@ -190,18 +452,20 @@ void Game::unmakeMove()
 	_unmakeMove();
 	mMoves.pop();
 	mHashs.pop();
-
-	mStatus = Ongoing;
+	mStates.pop_back();
 }
 
 u64 Game::_makeMove(const Move& move)
 {
-	u64 hash(Hashing::instance().hashTurn());
+	PROFILE_SCOPE(MakeMove);
+	TRACK_ALLOCATIONS(History);
+
+	u64 hash(Hashing::hashTurn());
 
-	hash ^= Hashing::instance().hashCastlingRights(mCastlingRights);
+	hash ^= Hashing::hashCastlingRights(mCastlingRights);
 
 	if (mEnPassantSquare != u8(-1))
-		hash ^= Hashing::instance().hashEnPassantFile(mEnPassantSquare % 8);
+		hash ^= Hashing::hashEnPassantFile(mEnPassantSquare % 8);
 
 
 	Undo undo({ move, nullptr, Pawn, mHalfmoveClock, mEnPassantSquare, mLastMovedPieceSquare, mCastlingRights });
@@ -279,10 +543,10 @@ u64 Game::_makeMove(const Move& move)
 	}
 
 
-	hash ^= Hashing::instance().hashCastlingRights(mCastlingRights);
+	hash ^= Hashing::hashCastlingRights(mCastlingRights);
 
 	if (mEnPassantSquare != u8(-1))
-		hash ^= Hashing::instance().hashEnPassantFile(mEnPassantSquare % 8);
+		hash ^= Hashing::hashEnPassantFile(mEnPassantSquare % 8);
 
 
 	// End the turn
@@ -294,9 +558,10 @@ u64 Game::_makeMove(const Move& move)
 
 void Game::_unmakeMove()
 {
+	PROFILE_SCOPE(UnmakeMove);
+
 	Undo undo(mHistory.back());
 
-	mStatus = Ongoing;
 	mActivePlayer = otherPlayer(mActivePlayer);
 	mHalfmoveClock = undo.halfmoveClock;
 	mEnPassantSquare = undo.enPassantSquare;
@@ -351,7 +616,10 @@ u64 Game::_addPiece(u8 square, PieceType type, Player player)
 
 	mPieceTypes[square] = type;
 
-	return Hashing::instance().hashPiece(square, type, player);
+	if (mNetwork)
+		mNetwork->addFeature(mAccumulator, square, type, player);
+
+	return Hashing::hashPiece(square, type, player);
 }
 
 u64 Game::_removePiece(u8 square, PieceType type, Player player)
@@ -364,7 +632,10 @@ u64 Game::_removePiece(u8 square, PieceType type, Player player)
 
 	mPieceTypes[square] = -1;
 
-	return Hashing::instance().hashPiece(square, type, player);
+	if (mNetwork)
+		mNetwork->removeFeature(mAccumulator, square, type, player);
+
+	return Hashing::hashPiece(square, type, player);
 }
 
 void Game::_refreshKingSquare(Player player)
@@ -373,9 +644,36 @@ void Game::_refreshKingSquare(Player player)
 	mKings[player] = bsfReset(kings);
 }
 
-void Game::_generateMoves()
+// The visits of the position are the same as when it was reached, since the later moves were all unmade
+void Game::_computeStatus() const
 {
-	mMoves.push(std::list<Move>());
+	PositionState& state(mStates.back());
+
+	state.status = Ongoing;
+
+	// If no moves are available, then the game is over
+	if (!hasLegalMoves()) {
+		if (isKingInCheck(mActivePlayer))
+			state.status = Status(1 - mActivePlayer); // Checkmate
+		else
+			state.status = Draw; // Stalemate
+	}
+
+	// Fifty-move rule or threefold repetition
+	std::map<u64, u8>::const_iterator visits(mHashsVisits.find(hash()));
+
+	if (mHalfmoveClock == 100 || (visits != mHashsVisits.end() && visits->second == 3))
+		state.status = Draw;
+
+	state.computed |= sStatusComputed;
+}
+
+void Game::_generateMoves() const
+{
+	PROFILE_SCOPE(MoveGeneration);
+	TRACK_ALLOCATIONS(MoveGeneration);
+
+	mMoves.top().clear();
 
 	_addPawnMoves(mActivePlayer);
 	_addKnightMoves(mActivePlayer);
@@ -384,13 +682,15 @@ void Game::_generateMoves()
 	_addQueenMoves(mActivePlayer);
 	_addKingMoves(mActivePlayer);
 
-	for (std::list<Move>::iterator it(mMoves.top().begin()); it != mMoves.top().end(); ++it) {
-		_makeMove(*it);
+	{
+		PROFILE_SCOPE(LegalityFilter);
 
-		if (isKingInCheck(otherPlayer(mActivePlayer)))
-			mMoves.top().erase(it);
-
-		_unmakeMove();
+		for (std::list<Move>::iterator it(mMoves.top().begin()); it != mMoves.top().end();) {
+			if (_isLegal(*it))
+				++it;
+			else
+				it = mMoves.top().erase(it);
+		}
 	}
 
 	if (_canCastleKingSide(mActivePlayer))
@@ -398,9 +698,11 @@ void Game::_generateMoves()
 
 	if (_canCastleQueenSide(mActivePlayer))
 		mMoves.top().push_back(Move(sCastleDelta[mActivePlayer] + 4, sCastleDelta[mActivePlayer] + 2, QueenCastle));
+
+	mStates.back().computed |= sMovesGenerated;
 }
 
-void Game::_addPawnMoves(Player player)
+void Game::_addPawnMoves(Player player) const
 {
 	u64 pushMoves(0), captureMoves(0),
 		pawns(piecesOf(player, Pawn)),
@@ -437,7 +739,7 @@ void Game::_addPawnMoves(Player player)
 	_addMovesShift(2 * sPawnShift[player], pushMoves, DoublePush);
 }
 
-void Game::_addKnightMoves(Player player)
+void Game::_addKnightMoves(Player player) const
 {
 	u8 square(0);
 	u64 moves(0), knights(piecesOf(player, Knight));
@@ -452,7 +754,7 @@ void Game::_addKnightMoves(Player player)
 	}
 }
 
-void Game::_addBishopMoves(Player player)
+void Game::_addBishopMoves(Player player) const
 {
 	u8 square(0);
 	u64 moves(0), bishops(piecesOf(player, Bishop));
@@ -466,7 +768,7 @@ void Game::_addBishopMoves(Player player)
 	}
 }
 
-void Game::_addRookMoves(Player player)
+void Game::_addRookMoves(Player player) const
 {
 	u8 square(0);
 	u64 moves(0), rooks(piecesOf(player, Rook));
@@ -480,7 +782,7 @@ void Game::_addRookMoves(Player player)
 	}
 }
 
-void Game::_addQueenMoves(Player player)
+void Game::_addQueenMoves(Player player) const
 {
 	u8 square(0);
 	u64 moves(0), queens(piecesOf(player, Queen));
@@ -494,7 +796,7 @@ void Game::_addQueenMoves(Player player)
 	}
 }
 
-void Game::_addKingMoves(Player player)
+void Game::_addKingMoves(Player player) const
 {
 	u64 moves = MoveGenerator::instance().kingMoves(mKings[player]);
 
@@ -502,7 +804,7 @@ void Game::_addKingMoves(Player player)
 	_addMovesFrom(mKings[player], moves & mPlayers[otherPlayer(player)], Capture);
 }
 
-void Game::_addMovesFrom(u8 from, u64 moves, MoveType type)
+void Game::_addMovesFrom(u8 from, u64 moves, MoveType type) const
 {
 	u8 to(0);
 
@@ -512,7 +814,7 @@ void Game::_addMovesFrom(u8 from, u64 moves, MoveType type)
 	}
 }
 
-void Game::_addMovesShift(i8 delta, u64 moves, MoveType type)
+void Game::_addMovesShift(i8 delta, u64 moves, MoveType type) const
 {
 	u8 to(0);
 
@@ -522,7 +824,7 @@ void Game::_addMovesShift(i8 delta, u64 moves, MoveType type)
 	}
 }
 
-void Game::_addPromoShift(i8 delta, u64 moves)
+void Game::_addPromoShift(i8 delta, u64 moves) const
 {
 	u8 to(0);
 
@@ -535,7 +837,7 @@ void Game::_addPromoShift(i8 delta, u64 moves)
 	}
 }
 
-void Game::_addPromoCaptureShift(i8 delta, u64 moves)
+void Game::_addPromoCaptureShift(i8 delta, u64 moves) const
 {
 	u8 to(0);
 
@@ -548,32 +850,105 @@ void Game::_addPromoCaptureShift(i8 delta, u64 moves)
 	}
 }
 
-bool Game::_isAttacked(u8 square, Player player) const
+// Pseudo-legal move of the active player, other than a castle
+bool Game::_isLegal(const Move& move) const
+{
+	const MoveGenerator& generator(MoveGenerator::instance());
+	Player by(otherPlayer(mActivePlayer));
+	u8 king(mKings[mActivePlayer]);
+	u64 to(u64(1) << move.to());
+
+	// The captured pawn also leaves its line : the sliders are looked up through the squares emptied by the capture,
+	// the other checkers must be that pawn
+	if (move.type() == EnPassant) {
+		u64 captured(u64(1) << (move.to() + sPawnShift[by]));
+		u64 occupancy((mOccupancy ^ (u64(1) << move.from()) ^ captured) | to);
+		u64 sliders((generator.rookMoves(king, occupancy) & (piecesOf(by, Rook) | piecesOf(by, Queen))) |
+		            (generator.bishopMoves(king, occupancy) & (piecesOf(by, Bishop) | piecesOf(by, Queen))));
+
+		return !sliders && !(checkers() & (piecesOf(by, Knight) | piecesOf(by, Pawn)) & ~captured);
+	}
+
+	// The attacks of the other player see through the king, which cannot step back along the line of a slider
+	if (move.from() == king)
+		return !(attacks(otherPlayer(mActivePlayer)) & to);
+
+	u64 checkers(this->checkers());
+
+	// In check, the checker must be captured or blocked, and only the king can answer a double check
+	if (checkers) {
+		if (checkers & (checkers - 1))
+			return false;
+
+		u64 checker(checkers);
+
+		if (!((checkers | generator.between(king, bsfReset(checker))) & to))
+			return false;
+	}
+
+	// A pinned piece stays on its line
+	return !(pinned() & (u64(1) << move.from())) || (generator.line(king, move.from()) & to);
+}
+
+// The pieces giving check to the active player, and its pieces shielding its king from a slider
+void Game::_computeCheckers() const
+{
+	const MoveGenerator& generator(MoveGenerator::instance());
+	PositionState& state(mStates.back());
+	Player by(otherPlayer(mActivePlayer));
+	u8 king(mKings[mActivePlayer]);
+
+	state.checkers = attackersTo(king, mOccupancy) & mPlayers[by];
+	state.pinned = 0;
+
+	u64 snipers((generator.rookMoves(king, 0) & (piecesOf(by, Rook) | piecesOf(by, Queen))) |
+	            (generator.bishopMoves(king, 0) & (piecesOf(by, Bishop) | piecesOf(by, Queen))));
+
+	while (snipers) {
+		u64 blockers(generator.between(king, bsfReset(snipers)) & mOccupancy);
+
+		if (popcount(blockers) == 1)
+			state.pinned |= blockers & mPlayers[mActivePlayer];
+	}
+
+	state.computed |= sCheckersComputed;
+}
+
+void Game::_computeAttacks(Player player) const
 {
-	Player by(otherPlayer(player));
+	const MoveGenerator& generator(MoveGenerator::instance());
+	PositionState& state(mStates.back());
+	u64 occupancy(mOccupancy & ~piecesOf(otherPlayer(player), King));
+	u64 pushes(circularShift(piecesOf(player, Pawn), sPawnShift[player]));
+	u64 attacks((circularShift(pushes, 1) & ~MoveGenerator::file(FileA)) | (circularShift(pushes, 64 - 1) & ~MoveGenerator::file(FileH)));
+
+	attacks |= generator.kingMoves(mKings[player]);
+
+	for (u64 knights(piecesOf(player, Knight)); knights;)
+		attacks |= generator.knightMoves(bsfReset(knights));
 
-	u64 left = (u64(1) << (square - 1)) & ~MoveGenerator::file(FileH),
-		right = (u64(1) << (square + 1)) & ~MoveGenerator::file(FileA);
+	for (u64 bishops(piecesOf(player, Bishop) | piecesOf(player, Queen)); bishops;)
+		attacks |= generator.bishopMoves(bsfReset(bishops), occupancy);
 
-	return MoveGenerator::instance().rookMoves(square, occupancy()) & (piecesOf(by, Rook) | piecesOf(by, Queen)) ||
-		   MoveGenerator::instance().bishopMoves(square, occupancy()) & (piecesOf(by, Bishop) | piecesOf(by, Queen)) ||
-		   MoveGenerator::instance().knightMoves(square) & piecesOf(by, Knight) ||
-		   MoveGenerator::instance().kingMoves(square) & piecesOf(by, King) ||
-		   (circularShift(left | right, sPawnShift[player]) & piecesOf(by, Pawn));
+	for (u64 rooks(piecesOf(player, Rook) | piecesOf(player, Queen)); rooks;)
+		attacks |= generator.rookMoves(bsfReset(rooks), occupancy);
+
+	state.attacks[player] = attacks;
+	state.computed |= sAttacksComputed << player;
 }
 
 bool Game::_canCastleKingSide(Player player) const
 {
 	return (mCastlingRights & (WhiteKingCastle << sCastleShift[player])) &&
 		!(mOccupancy & (u64(0x60) << sCastleDelta[player])) &&
-		!(isKingInCheck(player) || _isAttacked(sCastleDelta[player] + 5, player) || _isAttacked(sCastleDelta[player] + 6, player));
+		!(isKingInCheck(player) || (attacks(otherPlayer(player)) & (u64(0x60) << sCastleDelta[player])));
 }
 
 bool Game::_canCastleQueenSide(Player player) const
 {
 	return (mCastlingRights & (WhiteQueenCastle << sCastleShift[player])) &&
 		!(mOccupancy & (u64(0xE) << sCastleDelta[player])) &&
-		!(isKingInCheck(player) || _isAttacked(sCastleDelta[player] + 3, player) || _isAttacked(sCastleDelta[player] + 2, player));
+		!(isKingInCheck(player) || (attacks(otherPlayer(player)) & (u64(0xC) << sCastleDelta[player])));
 }
 
 
@@ -594,3 +969,49 @@ void perft(Game* game, u64& nodes, int depth)
 		nodes += moves.size();
 	}
 }
+
+// Walks the game tree and compares the incrementally updated hash with its full computation at every node
+bool checkHashes(Game* game, int depth)
+{
+	if (game->hash() != game->computeHash())
+		return false;
+
+	if (!depth)
+		return true;
+
+	std::list<Move> moves(game->possibleMoves());
+
+	for (Move move : moves) {
+		game->makeMove(move);
+		bool isValid(checkHashes(game, depth - 1));
+		game->unmakeMove();
+
+		if (!isValid || game->hash() != game->computeHash())
+			return false;
+	}
+
+	return true;
+}
+
+// Walks the game tree and compares the incrementally updated accumulator with its full computation at every node
+bool checkAccumulators(Game* game, int depth)
+{
+	if (game->accumulator() != game->computeAccumulator())
+		return false;
+
+	if (!depth)
+		return true;
+
+	std::list<Move> moves(game->possibleMoves());
+
+	for (Move move : moves) {
+		game->makeMove(move);
+		bool isValid(checkAccumulators(game, depth - 1));
+		game->unmakeMove();
+
+		if (!isValid || game->accumulator() != game->computeAccumulator())
+			return false;
+	}
+
+	return true;
+}
@@ -4,6 +4,9 @@
 #include "Move.h"
 #include "MoveGenerator.h"
 #include "Hashing.h"
+#include "NNUE.h"
+#include "Profiler.h"
+#include "MemoryTracker.h"
 
 struct Undo
 {
@@ -18,10 +21,22 @@ struct Undo
 	u8 castlingRights;
 };
 
+// State of a position computed on first use, and dropped when its move is unmade
+struct PositionState
+{
+	u64 checkers;               // Pieces giving check to the active player
+	u64 pinned;                 // Pieces of the active player pinned to its king
+	std::array<u64, 2> attacks; // Squares attacked by each player, its sliders seeing through the other king
+	Status status;
+
+	u8 computed;                // Flags of the fields above, and of the moves list, which are up to date
+};
+
 class Game
 {
 public:
 	Game();
+	Game(const std::string&);
 	Game(const Game&);
 
 	~Game();
@@ -35,18 +50,32 @@ public:
 
 	Player activePlayer() const;
 	u8 castlingRights() const;
+	u8 halfmoveClock() const;
 	u8 enPassantSquare() const;
 	u8 lastMovedSquare() const;
+	Move lastMove() const;
 
 	u64 hash() const;
+	u64 computeHash() const;
+
+	const Accumulator& accumulator() const;
+	Accumulator computeAccumulator() const;
+	void refreshAccumulator();
 
 	const std::list<Move>& possibleMoves() const;
+	bool hasLegalMoves() const;
 
 	Status status() const;
 
 	bool isOver() const;
 	bool isKingInCheck(Player) const;
 
+	u64 checkers() const;
+	u64 pinned() const;
+	u64 attacks(Player) const;
+
+	u64 attackersTo(u8, u64) const;
+
 	void makeMove(const Move&);
 	void unmakeMove();
 
@@ -69,23 +98,27 @@ private:
 	u64 _removePiece(u8, PieceType, Player);
 
 	void _refreshKingSquare(Player);
+	void _computeStatus() const;
+
+	void _generateMoves() const;
 
-	void _generateMoves();
 
+	void _addPawnMoves(Player) const;
+	void _addKnightMoves(Player) const;
+	void _addBishopMoves(Player) const;
+	void _addRookMoves(Player) const;
+	void _addQueenMoves(Player) const;
+	void _addKingMoves(Player) const;
 
-	void _addPawnMoves(Player);
-	void _addKnightMoves(Player);
-	void _addBishopMoves(Player);
-	void _addRookMoves(Player);
-	void _addQueenMoves(Player);
-	void _addKingMoves(Player);
+	void _addMovesFrom(u8, u64, MoveType) const;
+	void _addMovesShift(i8, u64, MoveType) const;
+	void _addPromoShift(i8, u64) const;
+	void _addPromoCaptureShift(i8, u64) const;
 
-	void _addMovesFrom(u8, u64, MoveType);
-	void _addMovesShift(i8, u64, MoveType);
-	void _addPromoShift(i8, u64);
-	void _addPromoCaptureShift(i8, u64);
+	bool _isLegal(const Move&) const;
 
-	bool _isAttacked(u8, Player) const;
+	void _computeCheckers() const;
+	void _computeAttacks(Player) const;
 
 	bool _canCastleKingSide(Player) const;
 	bool _canCastleQueenSide(Player) const;
@@ -105,16 +138,21 @@ private:
 	u8 mLastMovedPieceSquare;
 	u8 mCastlingRights;
 
-	Status mStatus;
-
-	std::stack<std::list<Move>> mMoves;
+	mutable std::stack<std::list<Move>> mMoves;
 	std::vector<Undo> mHistory;
 	std::stack<u64> mHashs;
+	mutable std::vector<PositionState> mStates;
 
 	std::map<u64, u8> mHashsVisits;
+
+	// Null when no network was loaded at the last refresh : the accumulator is then not maintained
+	const NNUE* mNetwork;
+	Accumulator mAccumulator;
 };
 
 
 void perft(Game*, u64&, int);
+bool checkHashes(Game*, int);
+bool checkAccumulators(Game*, int);
 
 #endif // GAME_H
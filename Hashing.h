@@ -3,28 +3,59 @@
 
 #include "defs.h"
 
-// Zobrist hashing
-class Hashing
+// Zobrist keys, generated at compile time from a fixed seed : the hashes are the same on every run and every build
+struct ZobristKeys
 {
-public:
-	static Hashing& instance();
+	u64 turn;
+
+	std::array<std::array<std::array<u64, 64>, 6>, 2> pieces;
+	std::array<u64, 16> castlingRights;
+	std::array<u64, 8> enPassantFile;
+};
 
-	u64 hashPiece(u8, PieceType, Player) const;
-	u64 hashTurn() const;
+// SplitMix64 pseudo-random generator
+constexpr u64 splitMix64(u64& state)
+{
+	u64 z(state += 0x9E3779B97F4A7C15);
 
-	u64 hashCastlingRights(u8) const;
-	u64 hashEnPassantFile(u8) const;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
 
-private:
-	Hashing();
+	return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys generateZobristKeys(u64 seed)
+{
+	ZobristKeys keys = {};
+
+	keys.turn = splitMix64(seed);
 
-	static Hashing sInstance;
+	for (u8 player(0); player < 2; ++player)
+		for (u8 type(0); type < 6; ++type)
+			for (u8 square(0); square < 64; ++square)
+				keys.pieces[player][type][square] = splitMix64(seed);
 
-	u64 mTurn;
+	for (u8 i(0); i < 16; ++i)
+		keys.castlingRights[i] = splitMix64(seed);
 
-	std::array<std::array<std::array<u64, 64>, 6>, 2> mPieces;
-	std::array<u64, 16> mCastlingRights;
-	std::array<u64, 8> mEnPassantFile;
+	for (u8 i(0); i < 8; ++i)
+		keys.enPassantFile[i] = splitMix64(seed);
+
+	return keys;
+}
+
+// Zobrist hashing
+class Hashing
+{
+public:
+	static constexpr u64 hashPiece(u8 square, PieceType type, Player player) { return sKeys.pieces[player][type][square]; }
+	static constexpr u64 hashTurn() { return sKeys.turn; }
+
+	static constexpr u64 hashCastlingRights(u8 r) { return sKeys.castlingRights[r]; }
+	static constexpr u64 hashEnPassantFile(u8 file) { return sKeys.enPassantFile[file]; }
+
+private:
+	static constexpr ZobristKeys sKeys = generateZobristKeys(0x5EED);
 };
 
 #endif // HASHING_H
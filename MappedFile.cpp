@@ -0,0 +1,118 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+	mData(nullptr),
+	mSize(0)
+#ifdef _WIN32
+	, mFile(INVALID_HANDLE_VALUE),
+	mMapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+	LARGE_INTEGER size;
+
+	if (mFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(mFile, &size) || !size.QuadPart) {
+		close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (mMapping != nullptr)
+		mData = static_cast<const u8*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (mData == nullptr) {
+		close();
+		return false;
+	}
+
+	mSize = size_t(size.QuadPart);
+#else
+	int file(::open(path.c_str(), O_RDONLY));
+
+	if (file == -1)
+		return false;
+
+	struct stat status;
+
+	if (fstat(file, &status) == -1 || !status.st_size) {
+		::close(file);
+		return false;
+	}
+
+	void* data(mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, file, 0));
+
+	// The mapping stays valid once the descriptor is closed
+	::close(file);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	mData = static_cast<const u8*>(data);
+	mSize = size_t(status.st_size);
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+
+	if (mMapping != nullptr)
+		CloseHandle(mMapping);
+
+	if (mFile != INVALID_HANDLE_VALUE)
+		CloseHandle(mFile);
+
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = nullptr;
+#else
+	if (mData != nullptr)
+		munmap(const_cast<u8*>(mData), mSize);
+#endif
+
+	mData = nullptr;
+	mSize = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+	return mData != nullptr;
+}
+
+const u8* MappedFile::data() const
+{
+	return mData;
+}
+
+size_t MappedFile::size() const
+{
+	return mSize;
+}
@@ -0,0 +1,33 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include "defs.h"
+
+// Read-only memory mapping of a whole file : opening costs nothing whatever the size, the pages are read on access
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string&);
+	void close();
+
+	bool isOpen() const;
+	const u8* data() const;
+	size_t size() const;
+
+private:
+	const u8* mData;
+	size_t mSize;
+
+#ifdef _WIN32
+	void* mFile;
+	void* mMapping;
+#endif
+};
+
+#endif // MAPPEDFILE_H
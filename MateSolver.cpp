@@ -0,0 +1,334 @@
+#include "MateSolver.h"
+
+// Proof and disproof numbers saturate below this value, which marks a proven or disproven position
+const u32 MateSolver::sInfinity = 1 << 30;
+
+// False only for moves which cannot check : the last move of a mate is tested without being played
+static bool mayGiveCheck(const Game& game, const Move& move)
+{
+	if (move.type() == KingCastle || move.type() == QueenCastle || move.type() == EnPassant || move.type() >= KnightPromo)
+		return true;
+
+	const MoveGenerator& generator(MoveGenerator::instance());
+	Player player(game.activePlayer());
+
+	u64 kingMask(game.piecesOf(otherPlayer(player), King)), kings(kingMask);
+	u8 king(bsfReset(kings));
+	u64 occupancy((game.occupancy() & ~(u64(1) << move.from())) | (u64(1) << move.to()));
+
+	// Discovered check : the piece leaves a line of the king
+	if (generator.queenMoves(king, 0) & (u64(1) << move.from()))
+		return true;
+
+	switch (game.pieceType(move.from())) {
+	case Pawn:
+		return generator.pawnAttacks(move.to(), player) & kingMask;
+
+	case Knight:
+		return generator.knightMoves(move.to()) & kingMask;
+
+	case Bishop:
+		return generator.bishopMoves(move.to(), occupancy) & kingMask;
+
+	case Rook:
+		return generator.rookMoves(move.to(), occupancy) & kingMask;
+
+	case Queen:
+		return generator.queenMoves(move.to(), occupancy) & kingMask;
+
+	default:
+		return false;
+	}
+}
+
+MateSolver::MateSolver(size_t entries) :
+	mAttacker(White),
+	mRootPlies(0),
+	mNodes(0),
+	mMaxNodes(0),
+	mIsStopped(false),
+	mIsSearching(false)
+{
+	// A power of two, so that the index is a mask of the hash
+	size_t size(2);
+
+	while (size * 2 <= entries)
+		size *= 2;
+
+	mTable.resize(size);
+	clear();
+}
+
+void MateSolver::clear()
+{
+	std::fill(mTable.begin(), mTable.end(), ProofEntry({ 0, 0, 0, 0, 0, 0 }));
+}
+
+MateResult MateSolver::solve(const Game& game, Player attacker, u8 moves, u64 nodes)
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	MateResult result({ false, 0, std::vector<Move>(), Move(), 0, 0 });
+
+	Game root(game);
+
+	mAttacker = attacker;
+	mNodes = 0;
+	mMaxNodes = nodes;
+	mIsStopped = false;
+	mIsSearching = true;
+
+	// The defender moves first when the attacker is not to move
+	u8 plies(u8(std::min(2 * moves - 1 + (root.activePlayer() != attacker), 255)));
+
+	mRootPlies = plies;
+	ProofEntry entry(_mid(&root, plies, sInfinity, sInfinity));
+
+	result.isMate = !entry.proof;
+
+	// The line follows the shortest proof for the attacker and the longest one for the defender, proving again the
+	// positions whose entries were replaced
+	while (result.isMate && !root.possibleMoves().empty()) {
+		bool isAttacker(root.activePlayer() == attacker);
+		Move best;
+		int bestDistance(isAttacker ? 256 : -1);
+
+		std::vector<Move> legalMoves(root.possibleMoves().begin(), root.possibleMoves().end());
+
+		// The attacker only needs the proofs still in the table, unless all of them were replaced
+		for (bool isProving : { false, true }) {
+			for (const Move& move : legalMoves) {
+				if (isProving && isAttacker && best != Move())
+					break;
+
+				root.makeMove(move);
+
+				ProofEntry child(_evaluate(root, u8(plies - 1), root.hash()));
+
+				if (child.proof && child.disproof && (isProving || !isAttacker))
+					child = _mid(&root, u8(plies - 1), sInfinity, sInfinity);
+
+				root.unmakeMove();
+
+				if (child.proof == 0 && (isAttacker ? child.distance < bestDistance : child.distance > bestDistance)) {
+					best = move;
+					bestDistance = child.distance;
+				}
+			}
+
+			if (!isAttacker || best != Move())
+				break;
+		}
+
+		// Only when interrupted while proving again
+		if (best == Move())
+			break;
+
+		result.line.push_back(best);
+		root.makeMove(best);
+		--plies;
+	}
+
+	result.moves = u8((result.line.size() + 1) / 2);
+	result.bestMove = result.isMate && !result.line.empty() ? result.line.front() : mRootBest;
+	result.nodes = mNodes;
+	result.time = u64(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count());
+
+	mIsSearching = false;
+
+	return result;
+}
+
+// Thread safe
+void MateSolver::stop()
+{
+	mIsStopped = true;
+}
+
+bool MateSolver::isSearching() const
+{
+	return mIsSearching;
+}
+
+// Multiple iterative deepening : the children are searched while the numbers of the node stay below the thresholds
+ProofEntry MateSolver::_mid(Game* game, u8 plies, u32 proofThreshold, u32 disproofThreshold)
+{
+	u64 hash(game->hash()), nodes(mNodes);
+	ProofEntry entry(_evaluate(*game, plies, hash));
+
+	if (!entry.proof || !entry.disproof)
+		return entry;
+
+	bool isAttacker(game->activePlayer() == mAttacker);
+	std::vector<Child> children;
+
+	std::vector<Move> moves(game->possibleMoves().begin(), game->possibleMoves().end());
+	children.reserve(moves.size());
+
+	for (const Move& move : moves) {
+		// With one ply left, a move which does not check is disproven
+		if (isAttacker && plies == 1 && !mayGiveCheck(*game, move))
+			continue;
+
+		game->makeMove(move);
+		++mNodes;
+
+		ProofEntry child(_evaluate(*game, u8(plies - 1), game->hash()));
+		children.push_back({ move, child.proof, child.disproof, child.distance });
+
+		game->unmakeMove();
+	}
+
+	while (true) {
+		// The attacker needs one proven child, the defender needs one disproven child
+		u32 proof(isAttacker ? sInfinity : 0), disproof(isAttacker ? 0 : sInfinity);
+		size_t best(0);
+		u32 second(sInfinity);
+
+		for (size_t i(0); i < children.size(); ++i) {
+			const Child& child(children[i]);
+			u32 number(isAttacker ? child.proof : child.disproof);
+
+			if (number < (isAttacker ? proof : disproof)) {
+				second = isAttacker ? proof : disproof;
+				best = i;
+			} else if (number < second)
+				second = number;
+
+			if (isAttacker) {
+				proof = std::min(proof, child.proof);
+				disproof = _add(disproof, child.disproof);
+			} else {
+				proof = _add(proof, child.proof);
+				disproof = std::min(disproof, child.disproof);
+			}
+		}
+
+		if (isAttacker && !proof)
+			disproof = sInfinity;
+		else if (!isAttacker && !disproof)
+			proof = sInfinity;
+
+		entry.proof = proof;
+		entry.disproof = disproof;
+
+		if (plies == mRootPlies && !children.empty())
+			mRootBest = children[best].move;
+
+		if (proof >= proofThreshold || disproof >= disproofThreshold || _isStopped())
+			break;
+
+		Child& child(children[best]);
+		u32 childProofThreshold, childDisproofThreshold;
+
+		// The search of the best child stops once it is no longer the best
+		if (isAttacker) {
+			childProofThreshold = std::min<u32>(proofThreshold, _add(second, second / 4 + 1));
+			childDisproofThreshold = u32(std::min<u64>(u64(disproofThreshold) - disproof + child.disproof, sInfinity));
+		} else {
+			childProofThreshold = u32(std::min<u64>(u64(proofThreshold) - proof + child.proof, sInfinity));
+			childDisproofThreshold = std::min<u32>(disproofThreshold, _add(second, second / 4 + 1));
+		}
+
+		game->makeMove(child.move);
+		ProofEntry result(_mid(game, u8(plies - 1), childProofThreshold, childDisproofThreshold));
+		game->unmakeMove();
+
+		child.proof = result.proof;
+		child.disproof = result.disproof;
+		child.distance = result.distance;
+	}
+
+	// Shortest mate for the attacker, longest for the defender
+	if (!entry.proof) {
+		int distance(isAttacker ? 255 : 0);
+
+		for (const Child& child : children) {
+			if (!child.proof)
+				distance = isAttacker ? std::min<int>(distance, child.distance) : std::max<int>(distance, child.distance);
+		}
+
+		entry.distance = u8(distance + 1);
+	}
+
+	entry.work = u32(std::min<u64>(mNodes - nodes, u32(-1)));
+	_store(entry);
+
+	return entry;
+}
+
+// Numbers of a position before its search : from the table, exact at the end of the game or of the plies, else
+// from the number of moves that the side to move must refute
+ProofEntry MateSolver::_evaluate(const Game& game, u8 plies, u64 hash)
+{
+	ProofEntry entry({ hash, 1, 1, 0, plies, 0 });
+
+	if (_lookup(hash, plies, entry))
+		return entry;
+
+	bool isAttacker(game.activePlayer() == mAttacker);
+
+	// Repetitions and the fifty-move rule are ignored : the plies left bound the search, and the numbers of a
+	// position must not depend on the path to it
+	if (!game.hasLegalMoves()) {
+		bool isMate(!isAttacker && game.isKingInCheck(game.activePlayer()));
+
+		entry.proof = isMate ? 0 : sInfinity;
+		entry.disproof = isMate ? sInfinity : 0;
+	} else if (plies < (isAttacker ? 1 : 2)) {
+		// The attacker cannot give mate with the plies left
+		entry.proof = sInfinity;
+		entry.disproof = 0;
+	} else if (isAttacker)
+		entry.disproof = u32(game.possibleMoves().size());
+	else
+		entry.proof = u32(game.possibleMoves().size());
+
+	return entry;
+}
+
+// A proof holds with more plies, a disproof with fewer
+bool MateSolver::_lookup(u64 hash, u8 plies, ProofEntry& result) const
+{
+	size_t index(hash & (mTable.size() - 2));
+
+	for (size_t i(index); i < index + 2; ++i) {
+		const ProofEntry& entry(mTable[i]);
+
+		if (entry.hash != hash)
+			continue;
+
+		if (entry.plies == plies || (!entry.proof && entry.plies <= plies) || (!entry.disproof && entry.plies >= plies)) {
+			result = entry;
+			result.plies = plies;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Buckets of two entries : the entry of the same position and plies, else the one with the least work is replaced
+void MateSolver::_store(const ProofEntry& entry)
+{
+	size_t index(entry.hash & (mTable.size() - 2));
+	ProofEntry* slot(&mTable[index]);
+
+	if (mTable[index + 1].hash == entry.hash && mTable[index + 1].plies == entry.plies)
+		slot = &mTable[index + 1];
+	else if (!(slot->hash == entry.hash && slot->plies == entry.plies) && mTable[index + 1].work < slot->work)
+		slot = &mTable[index + 1];
+
+	*slot = entry;
+}
+
+// Sum of numbers, which stays below the infinity while the position is neither proven nor disproven
+u32 MateSolver::_add(u32 a, u32 b)
+{
+	return u32(std::min<u64>(u64(a) + b, sInfinity - 1));
+}
+
+bool MateSolver::_isStopped() const
+{
+	return mIsStopped || (mMaxNodes && mNodes >= mMaxNodes);
+}
@@ -0,0 +1,75 @@
+#ifndef MATESOLVER_H
+#define MATESOLVER_H
+
+#include "Game.h"
+
+// Proof and disproof numbers of a position for a number of plies left, from the point of view of the attacker
+struct ProofEntry
+{
+	u64 hash;
+	u32 proof;
+	u32 disproof;
+	u32 work;     // Nodes spent on the position, the entries with the least work are replaced first
+	u8 plies;
+	u8 distance;  // Plies to the mate once proven
+};
+
+struct MateResult
+{
+	bool isMate;
+	u8 moves;               // Mate in this number of moves of the attacker
+	std::vector<Move> line; // Full mating line, the defender resisting as long as possible
+	Move bestMove;          // First move of the line, or the most promising move without a proof
+
+	u64 nodes;
+	u64 time;               // ms
+};
+
+// Depth-first proof-number search (df-pn) of forced mates : the attacker needs one move leading to a mate, the
+// defender must have none escaping it. The table has a fixed size, so that long proofs use bounded memory.
+class MateSolver
+{
+public:
+	MateSolver(size_t);
+
+	void clear();
+
+	// Mate in at most the given number of moves for the player : the mate found is not always the shortest
+	MateResult solve(const Game&, Player, u8, u64 nodes = 0);
+
+	void stop();
+	bool isSearching() const;
+
+private:
+	static const u32 sInfinity;
+
+	struct Child
+	{
+		Move move;
+		u32 proof;
+		u32 disproof;
+		u8 distance;
+	};
+
+	ProofEntry _mid(Game*, u8, u32, u32);
+	ProofEntry _evaluate(const Game&, u8, u64);
+
+	bool _lookup(u64, u8, ProofEntry&) const;
+	void _store(const ProofEntry&);
+
+	static u32 _add(u32, u32);
+	bool _isStopped() const;
+
+	std::vector<ProofEntry> mTable;
+
+	Player mAttacker;
+	u8 mRootPlies;
+	Move mRootBest;
+	u64 mNodes;
+	u64 mMaxNodes;
+
+	std::atomic<bool> mIsStopped;
+	std::atomic<bool> mIsSearching;
+};
+
+#endif // MATESOLVER_H
@@ -0,0 +1,165 @@
+#include "MemoryTracker.h"
+
+#ifdef CHESS_TRACK_ALLOCATIONS
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+const std::array<std::string, AllocationTagsCount> MemoryTracker::sNames = { "Untagged", "Transposition table", "Move generation", "Search", "History" };
+
+std::array<MemoryTracker::Counters, AllocationTagsCount> MemoryTracker::sCounters = {};
+thread_local AllocationTag MemoryTracker::sTag = Untagged;
+
+AllocationTag MemoryTracker::tag()
+{
+	return sTag;
+}
+
+// Returns the previous tag so that the scopes can be nested
+AllocationTag MemoryTracker::setTag(AllocationTag tag)
+{
+	AllocationTag previous(sTag);
+	sTag = tag;
+
+	return previous;
+}
+
+void MemoryTracker::allocated(AllocationTag tag, u64 size)
+{
+	Counters& counters(sCounters[tag]);
+
+	u64 current(counters.current.fetch_add(size, std::memory_order_relaxed) + size);
+	u64 peak(counters.peak.load(std::memory_order_relaxed));
+
+	while (current > peak && !counters.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed));
+
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryTracker::deallocated(AllocationTag tag, u64 size)
+{
+	sCounters[tag].current.fetch_sub(size, std::memory_order_relaxed);
+	sCounters[tag].deallocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+AllocationUsage MemoryTracker::usage(AllocationTag tag)
+{
+	const Counters& counters(sCounters[tag]);
+
+	return { counters.current.load(), counters.peak.load(), counters.allocations.load(), counters.deallocations.load() };
+}
+
+// The peaks restart from the current usage, e.g. to measure a single search
+void MemoryTracker::resetPeaks()
+{
+	for (Counters& counters : sCounters)
+		counters.peak = counters.current.load();
+}
+
+void MemoryTracker::report(std::ostream& stream)
+{
+	char line[128];
+
+	snprintf(line, sizeof(line), "%-20s %14s %14s %14s %14s\n", "Subsystem", "Current (B)", "Peak (B)", "Allocations", "Frees");
+	stream << line;
+
+	for (u8 i(0); i < AllocationTagsCount; ++i) {
+		AllocationUsage counters(usage(AllocationTag(i)));
+
+		snprintf(line, sizeof(line), "%-20s %14llu %14llu %14llu %14llu\n", sNames[i].c_str(), counters.current, counters.peak, counters.allocations, counters.deallocations);
+		stream << line;
+	}
+}
+
+// Each block is preceded by a header keeping its size and tag, the deallocation may happen under another tag
+namespace
+{
+	struct alignas(std::max_align_t) BlockHeader
+	{
+		u64 size;
+		AllocationTag tag;
+	};
+
+	void* trackedAllocate(size_t size)
+	{
+		BlockHeader* header(static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size)));
+
+		if (header == nullptr)
+			return nullptr;
+
+		header->size = size;
+		header->tag = MemoryTracker::tag();
+		MemoryTracker::allocated(header->tag, size);
+
+		return header + 1;
+	}
+
+	void trackedDeallocate(void* pointer)
+	{
+		if (pointer == nullptr)
+			return;
+
+		BlockHeader* header(static_cast<BlockHeader*>(pointer) - 1);
+
+		MemoryTracker::deallocated(header->tag, header->size);
+		std::free(header);
+	}
+}
+
+void* operator new(size_t size)
+{
+	void* pointer(trackedAllocate(size));
+
+	if (pointer == nullptr)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return trackedAllocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return trackedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	trackedDeallocate(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	trackedDeallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	trackedDeallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	trackedDeallocate(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	trackedDeallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	trackedDeallocate(pointer);
+}
+
+#endif // CHESS_TRACK_ALLOCATIONS
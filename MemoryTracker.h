@@ -0,0 +1,79 @@
+#ifndef MEMORYTRACKER_H
+#define MEMORYTRACKER_H
+
+#include "defs.h"
+
+// Heap usage per engine subsystem, compiled out unless CHESS_TRACK_ALLOCATIONS is defined.
+// The global operator new/delete are replaced and attribute each block to the innermost tag of the allocating thread.
+
+#ifdef CHESS_TRACK_ALLOCATIONS
+
+enum AllocationTag {
+	Untagged,
+	TranspositionTableAllocations,
+	MoveGenerationAllocations,
+	SearchAllocations,
+	HistoryAllocations,
+	AllocationTagsCount
+};
+
+struct AllocationUsage
+{
+	u64 current;
+	u64 peak;
+	u64 allocations;
+	u64 deallocations;
+};
+
+class MemoryTracker
+{
+public:
+	static AllocationTag tag();
+	static AllocationTag setTag(AllocationTag);
+
+	static void allocated(AllocationTag, u64);
+	static void deallocated(AllocationTag, u64);
+
+	static AllocationUsage usage(AllocationTag);
+	static void resetPeaks();
+	static void report(std::ostream&);
+
+private:
+	struct Counters
+	{
+		std::atomic<u64> current;
+		std::atomic<u64> peak;
+		std::atomic<u64> allocations;
+		std::atomic<u64> deallocations;
+	};
+
+	static const std::array<std::string, AllocationTagsCount> sNames;
+
+	static std::array<Counters, AllocationTagsCount> sCounters;
+	static thread_local AllocationTag sTag;
+};
+
+class ScopedAllocationTag
+{
+public:
+	ScopedAllocationTag(AllocationTag tag) : mPrevious(MemoryTracker::setTag(tag)) {}
+	~ScopedAllocationTag() { MemoryTracker::setTag(mPrevious); }
+
+private:
+	AllocationTag mPrevious;
+};
+
+#define TRACK_ALLOCATIONS_CONCAT_(a, b) a##b
+#define TRACK_ALLOCATIONS_CONCAT(a, b) TRACK_ALLOCATIONS_CONCAT_(a, b)
+
+#define TRACK_ALLOCATIONS(tag) ScopedAllocationTag TRACK_ALLOCATIONS_CONCAT(allocationTag, __LINE__)(tag##Allocations)
+#define ALLOCATIONS_REPORT(stream) MemoryTracker::report(stream)
+
+#else
+
+#define TRACK_ALLOCATIONS(tag)
+#define ALLOCATIONS_REPORT(stream)
+
+#endif // CHESS_TRACK_ALLOCATIONS
+
+#endif // MEMORYTRACKER_H
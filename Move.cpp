@@ -1,6 +1,7 @@
 #include "Move.h"
 
-Move::Move()
+Move::Move() :
+	mMove(0)
 {
 }
 
@@ -44,6 +45,22 @@ PieceType Move::promotionType() const
 	return PieceType((type() & 0x3) + 1);
 }
 
+// Coordinate notation, as used by UCI (e2e4, e7e8q)
+std::string Move::toString() const
+{
+	std::string str;
+
+	str += 'a' + from() % 8;
+	str += '1' + from() / 8;
+	str += 'a' + to() % 8;
+	str += '1' + to() / 8;
+
+	if (isPromotion())
+		str += "nbrq"[promotionType() - Knight];
+
+	return str;
+}
+
 bool operator==(const Move& a, const Move& b)
 {
 	return a.mMove == b.mMove;
@@ -18,6 +18,8 @@ public:
 	MoveType type() const;
 	PieceType promotionType() const;
 
+	std::string toString() const;
+
 	friend bool operator==(const Move&, const Move&);
 
 private:
@@ -45,6 +45,11 @@ u64 MoveGenerator::kingMoves(u8 square) const
 	return mKingMoves[square];
 }
 
+u64 MoveGenerator::pawnAttacks(u8 square, Player player) const
+{
+	return mPawnAttacks[player][square];
+}
+
 u64 MoveGenerator::rookMoves(u8 square, u64 occupancy) const
 {
 	return mRookMoves[square][((occupancy & mRookBlockmasks[square]) * mRookMagics[square]) >> (64 - popcount(mRookBlockmasks[square]))];
@@ -60,6 +65,18 @@ u64 MoveGenerator::queenMoves(u8 square, u64 occupancy) const
 	return rookMoves(square, occupancy) | bishopMoves(square, occupancy);
 }
 
+// Squares strictly between two aligned squares, empty if they are not aligned
+u64 MoveGenerator::between(u8 from, u8 to) const
+{
+	return mBetween[from][to];
+}
+
+// Whole line through two aligned squares, empty if they are not aligned
+u64 MoveGenerator::line(u8 from, u8 to) const
+{
+	return mLines[from][to];
+}
+
 MoveGenerator::MoveGenerator()
 {
 	sFiles[FileA] = 0x0101010101010101;
@@ -82,7 +99,7 @@ MoveGenerator::MoveGenerator()
 
 	u64 shiftedIndex(0);
 
-	std::cout << "Initializing :\n* Knight moves...";
+	std::cerr << "Initializing :\n* Knight moves...";
 
 	// Knight moves
 	for (u8 i(0); i < 64; ++i) {
@@ -100,7 +117,7 @@ MoveGenerator::MoveGenerator()
 		mKnightMoves[i] |= (shiftedIndex >> 10) & ~(file(FileG) | file(FileH));
 	}
 
-	std::cout << " done !\n* King moves...";
+	std::cerr << " done !\n* King moves...";
 
 	// King moves
 	for (u8 i(0); i < 64; ++i) {
@@ -118,7 +135,17 @@ MoveGenerator::MoveGenerator()
 		mKingMoves[i] |= (shiftedIndex >> 1) & ~file(FileH);
 	}
 
-	std::cout << " done !\n* Rook moves...";
+	std::cerr << " done !\n* Pawn attacks...";
+
+	// Pawn attacks
+	for (u8 i(0); i < 64; ++i) {
+		shiftedIndex = static_cast<u64>(1) << i;
+
+		mPawnAttacks[White][i] = ((shiftedIndex << 7) & ~file(FileH)) | ((shiftedIndex << 9) & ~file(FileA));
+		mPawnAttacks[Black][i] = ((shiftedIndex >> 9) & ~file(FileH)) | ((shiftedIndex >> 7) & ~file(FileA));
+	}
+
+	std::cerr << " done !\n* Rook moves...";
 
 	// Rook blockmasks
 	for (u8 r(0); r < 8; ++r) {
@@ -135,7 +162,7 @@ MoveGenerator::MoveGenerator()
 		}
 	}
 
-	std::cout << " done !\n* Bishop moves...";
+	std::cerr << " done !\n* Bishop moves...";
 
 	// Bishop blockmasks
 	for (u8 i(0); i < 64; ++i) {
@@ -145,7 +172,28 @@ MoveGenerator::MoveGenerator()
 		_generateMagics(i, Bishop);
 	}
 
-	std::cout << " done !\n";
+	// Lines and segments between aligned squares
+	for (u8 from(0); from < 64; ++from) {
+		for (u8 to(0); to < 64; ++to) {
+			u64 fromMask(u64(1) << from), toMask(u64(1) << to);
+
+			mBetween[from][to] = 0;
+			mLines[from][to] = 0;
+
+			if (from == to)
+				continue;
+
+			if (rookMoves(from, 0) & toMask) {
+				mBetween[from][to] = rookMoves(from, toMask) & rookMoves(to, fromMask);
+				mLines[from][to] = (rookMoves(from, 0) & rookMoves(to, 0)) | fromMask | toMask;
+			} else if (bishopMoves(from, 0) & toMask) {
+				mBetween[from][to] = bishopMoves(from, toMask) & bishopMoves(to, fromMask);
+				mLines[from][to] = (bishopMoves(from, 0) & bishopMoves(to, 0)) | fromMask | toMask;
+			}
+		}
+	}
+
+	std::cerr << " done !\n";
 }
 
 std::vector<u64> MoveGenerator::_subMasks(u64 mask)
@@ -180,15 +228,15 @@ void MoveGenerator::_generateMagics(u8 square, PieceType type)
 	u64 blockmask(type == Rook ? mRookBlockmasks[square] : mBishopBlockmasks[square]);
 	std::vector<u64>& movesArray(type == Rook ? mRookMoves[square] : mBishopMoves[square]);
 
-	std::default_random_engine generator(std::chrono::system_clock::now().time_since_epoch().count());
-	std::uniform_int_distribution<u64> distribution(0, -1);
+	// Fixed seed, so that the tables are the same on every run
+	std::mt19937_64 generator(64 * type + square);
 
 	u64 n(0);
 	bool fail(true);
 	std::vector<u64> subMasks(_subMasks(blockmask));
 
 	while (fail) {
-		n = distribution(generator) & distribution(generator) & distribution(generator); // Randomly generate a maybe magic number
+		n = generator() & generator() & generator(); // Randomly generate a maybe magic number
 		movesArray = std::vector<u64>(subMasks.size(), 0);
 
 		fail = false;
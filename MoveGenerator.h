@@ -16,11 +16,15 @@ public:
 
 	u64 knightMoves(u8) const;
 	u64 kingMoves(u8) const;
+	u64 pawnAttacks(u8, Player) const;
 
 	u64 rookMoves(u8, u64) const;
 	u64 bishopMoves(u8, u64) const;
 	u64 queenMoves(u8, u64) const;
 
+	u64 between(u8, u8) const;
+	u64 line(u8, u8) const;
+
 private:
 	MoveGenerator();
 
@@ -37,6 +41,7 @@ private:
 
 	std::array<u64, 64> mKnightMoves;
 	std::array<u64, 64> mKingMoves;
+	std::array<std::array<u64, 64>, 2> mPawnAttacks;
 
 	std::array<std::vector<u64>, 64> mRookMoves;
 	std::array<u64, 64> mRookMagics;
@@ -45,6 +50,9 @@ private:
 	std::array<std::vector<u64>, 64> mBishopMoves;
 	std::array<u64, 64> mBishopMagics;
 	std::array<u64, 64> mBishopBlockmasks;
+
+	std::array<std::array<u64, 64>, 64> mBetween;
+	std::array<std::array<u64, 64>, 64> mLines;
 };
 
 #endif // MOVEGENERATOR_H
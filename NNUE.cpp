@@ -0,0 +1,194 @@
+#include "NNUE.h"
+
+#if defined(__AVX2__)
+#define NNUE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#define NNUE_SSE2
+#endif
+
+#if defined(NNUE_AVX2) || defined(NNUE_SSE2)
+#include <immintrin.h>
+#endif
+
+NNUE NNUE::sInstance;
+
+const size_t NNUE::sInputs = 768;
+const size_t NNUE::sHiddenSize = 256;
+
+const int NNUE::sQuantizationA = 255;
+const int NNUE::sQuantizationB = 64;
+const int NNUE::sScale = 400;
+
+// The kernels work on the 256 first layer outputs of one perspective. The additions wrap around, so that removing
+// a piece exactly undoes its addition and the incremental accumulators always equal their full computation.
+
+static void addWeights(i16* values, const i16* weights)
+{
+#if defined(NNUE_AVX2)
+	for (size_t i(0); i < 256; i += 16) {
+		__m256i* v = reinterpret_cast<__m256i*>(values + i);
+		_mm256_storeu_si256(v, _mm256_add_epi16(_mm256_loadu_si256(v), _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i))));
+	}
+#elif defined(NNUE_SSE2)
+	for (size_t i(0); i < 256; i += 8) {
+		__m128i* v = reinterpret_cast<__m128i*>(values + i);
+		_mm_storeu_si128(v, _mm_add_epi16(_mm_loadu_si128(v), _mm_load_si128(reinterpret_cast<const __m128i*>(weights + i))));
+	}
+#else
+	for (size_t i(0); i < 256; ++i)
+		values[i] = i16(u16(values[i]) + u16(weights[i]));
+#endif
+}
+
+static void subtractWeights(i16* values, const i16* weights)
+{
+#if defined(NNUE_AVX2)
+	for (size_t i(0); i < 256; i += 16) {
+		__m256i* v = reinterpret_cast<__m256i*>(values + i);
+		_mm256_storeu_si256(v, _mm256_sub_epi16(_mm256_loadu_si256(v), _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i))));
+	}
+#elif defined(NNUE_SSE2)
+	for (size_t i(0); i < 256; i += 8) {
+		__m128i* v = reinterpret_cast<__m128i*>(values + i);
+		_mm_storeu_si128(v, _mm_sub_epi16(_mm_loadu_si128(v), _mm_load_si128(reinterpret_cast<const __m128i*>(weights + i))));
+	}
+#else
+	for (size_t i(0); i < 256; ++i)
+		values[i] = i16(u16(values[i]) - u16(weights[i]));
+#endif
+}
+
+// Sum of the products of the outputs clipped to [0, limit] with the output weights
+static int clippedDot(const i16* values, const i16* weights, int limit)
+{
+#if defined(NNUE_AVX2)
+	__m256i sum(_mm256_setzero_si256()), zero(_mm256_setzero_si256()), max(_mm256_set1_epi16(i16(limit)));
+
+	for (size_t i(0); i < 256; i += 16) {
+		__m256i v(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)));
+		v = _mm256_min_epi16(_mm256_max_epi16(v, zero), max);
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i))));
+	}
+
+	__m128i half(_mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+
+	return _mm_cvtsi128_si32(half);
+#elif defined(NNUE_SSE2)
+	__m128i sum(_mm_setzero_si128()), zero(_mm_setzero_si128()), max(_mm_set1_epi16(i16(limit)));
+
+	for (size_t i(0); i < 256; i += 8) {
+		__m128i v(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)));
+		v = _mm_min_epi16(_mm_max_epi16(v, zero), max);
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(v, _mm_load_si128(reinterpret_cast<const __m128i*>(weights + i))));
+	}
+
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+
+	return _mm_cvtsi128_si32(sum);
+#else
+	int sum(0);
+
+	for (size_t i(0); i < 256; ++i)
+		sum += std::min(std::max(int(values[i]), 0), limit) * weights[i];
+
+	return sum;
+#endif
+}
+
+bool Accumulator::operator==(const Accumulator& accumulator) const
+{
+	return values == accumulator.values;
+}
+
+bool Accumulator::operator!=(const Accumulator& accumulator) const
+{
+	return values != accumulator.values;
+}
+
+NNUE::NNUE() :
+	mOutputBias(0),
+	mIsLoaded(false)
+{
+}
+
+NNUE& NNUE::instance()
+{
+	return sInstance;
+}
+
+// The searches must be stopped : the games refresh their accumulators from the network loaded when they start
+bool NNUE::load(const std::string& path)
+{
+	unload();
+
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+	if (!file)
+		return false;
+
+	// Trainers usually pad the arrays to a multiple of 64 bytes
+	size_t size(file.tellg());
+	size_t expected(sizeof(i16) * (mInputWeights.size() + mInputBiases.size() + mOutputWeights.size() + 1));
+
+	if (size < expected || size >= expected + 64)
+		return false;
+
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(mInputWeights.data()), sizeof(i16) * mInputWeights.size());
+	file.read(reinterpret_cast<char*>(mInputBiases.data()), sizeof(i16) * mInputBiases.size());
+	file.read(reinterpret_cast<char*>(mOutputWeights.data()), sizeof(i16) * mOutputWeights.size());
+	file.read(reinterpret_cast<char*>(&mOutputBias), sizeof(mOutputBias));
+
+	mIsLoaded = bool(file);
+
+	return mIsLoaded;
+}
+
+void NNUE::unload()
+{
+	mIsLoaded = false;
+}
+
+bool NNUE::isLoaded() const
+{
+	return mIsLoaded;
+}
+
+// Accumulator of an empty board, the pieces are then added one by one
+void NNUE::reset(Accumulator& accumulator) const
+{
+	accumulator.values[White] = mInputBiases;
+	accumulator.values[Black] = mInputBiases;
+}
+
+void NNUE::addFeature(Accumulator& accumulator, u8 square, PieceType type, Player player) const
+{
+	addWeights(accumulator.values[White].data(), &mInputWeights[_feature(square, type, player, White) * sHiddenSize]);
+	addWeights(accumulator.values[Black].data(), &mInputWeights[_feature(square, type, player, Black) * sHiddenSize]);
+}
+
+void NNUE::removeFeature(Accumulator& accumulator, u8 square, PieceType type, Player player) const
+{
+	subtractWeights(accumulator.values[White].data(), &mInputWeights[_feature(square, type, player, White) * sHiddenSize]);
+	subtractWeights(accumulator.values[Black].data(), &mInputWeights[_feature(square, type, player, Black) * sHiddenSize]);
+}
+
+// Centipawns, from the point of view of the player
+int NNUE::evaluate(const Accumulator& accumulator, Player player) const
+{
+	int output(clippedDot(accumulator.values[player].data(), &mOutputWeights[0], sQuantizationA)
+	         + clippedDot(accumulator.values[otherPlayer(player)].data(), &mOutputWeights[sHiddenSize], sQuantizationA));
+
+	return int(i64(output + mOutputBias) * sScale / (sQuantizationA * sQuantizationB));
+}
+
+size_t NNUE::_feature(u8 square, PieceType type, Player player, Player perspective)
+{
+	if (perspective == Black)
+		square ^= 56;
+
+	return 384 * (player != perspective) + 64 * type + square;
+}
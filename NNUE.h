@@ -0,0 +1,61 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "defs.h"
+
+// First layer outputs of both perspectives, updated with each added or removed piece
+struct Accumulator
+{
+	std::array<std::array<i16, 256>, 2> values;
+
+	bool operator==(const Accumulator&) const;
+	bool operator!=(const Accumulator&) const;
+};
+
+// Efficiently updatable neural network : 768 piece-square inputs -> 256 per perspective -> 1.
+// The inputs of a perspective are the pieces of its player then the pieces of its opponent, its own side at the bottom.
+// The weights file holds the quantized int16 arrays in order, little-endian : input weights [768][256],
+// input biases [256], output weights [2][256] (side to move first) and the output bias.
+class NNUE
+{
+	NNUE(const NNUE&) = delete;
+	NNUE& operator=(const NNUE&) = delete;
+
+public:
+	static NNUE& instance();
+
+	static const size_t sInputs;
+	static const size_t sHiddenSize;
+
+	bool load(const std::string&);
+	void unload();
+
+	bool isLoaded() const;
+
+	void reset(Accumulator&) const;
+	void addFeature(Accumulator&, u8, PieceType, Player) const;
+	void removeFeature(Accumulator&, u8, PieceType, Player) const;
+
+	int evaluate(const Accumulator&, Player) const;
+
+private:
+	NNUE();
+
+	static size_t _feature(u8, PieceType, Player, Player);
+
+	static NNUE sInstance;
+
+	// Quantization of the first layer, of the output weights, and centipawns per unit of output
+	static const int sQuantizationA;
+	static const int sQuantizationB;
+	static const int sScale;
+
+	alignas(32) std::array<i16, 768 * 256> mInputWeights;
+	alignas(32) std::array<i16, 256> mInputBiases;
+	alignas(32) std::array<i16, 2 * 256> mOutputWeights;
+	i16 mOutputBias;
+
+	bool mIsLoaded;
+};
+
+#endif // NNUE_H
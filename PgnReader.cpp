@@ -0,0 +1,262 @@
+#include "PgnReader.h"
+
+static bool isSpace(char c)
+{
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static bool isResult(std::string_view token)
+{
+	return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+// Value of a tag in the tag lines : [Name "Value"], without unescaping
+std::string_view PgnGame::tag(std::string_view name) const
+{
+	size_t i(0);
+
+	while (i < tags.size()) {
+		size_t end(tags.find('\n', i));
+
+		if (end == std::string_view::npos)
+			end = tags.size();
+
+		std::string_view line(tags.substr(i, end - i));
+		i = end + 1;
+
+		if (line.size() < name.size() + 4 || line[0] != '[' || line.compare(1, name.size(), name) || line[name.size() + 1] != ' ')
+			continue;
+
+		size_t first(line.find('"', name.size() + 1)), last(line.rfind('"'));
+
+		if (first != std::string_view::npos && last > first)
+			return line.substr(first + 1, last - first - 1);
+	}
+
+	return std::string_view();
+}
+
+bool PgnReader::open(const std::string& path)
+{
+	return mFile.open(path);
+}
+
+void PgnReader::close()
+{
+	mFile.close();
+}
+
+size_t PgnReader::size() const
+{
+	return mFile.size();
+}
+
+// Offset of the first game starting at or after the offset, or the size of the file
+size_t PgnReader::nextGame(size_t offset) const
+{
+	const char* data(reinterpret_cast<const char*>(mFile.data()));
+	size_t size(mFile.size());
+
+	while (offset < size) {
+		const char* bracket(static_cast<const char*>(std::memchr(data + offset, '[', size - offset)));
+
+		if (!bracket)
+			return size;
+
+		size_t position(bracket - data);
+
+		if (position == 0)
+			return 0;
+
+		// At the start of a line which follows a blank one
+		if (data[position - 1] == '\n') {
+			size_t previous(position - 1);
+
+			if (previous && data[previous - 1] == '\r')
+				--previous;
+
+			if (!previous || data[previous - 1] == '\n')
+				return position;
+		}
+
+		offset = position + 1;
+	}
+
+	return size;
+}
+
+// Tag lines, then the movetext up to the next game : returns the offset of the next game
+size_t PgnReader::read(size_t offset, PgnGame& game) const
+{
+	const char* data(reinterpret_cast<const char*>(mFile.data()));
+	size_t size(mFile.size()), i(offset);
+
+	while (i < size && data[i] == '[') {
+		const char* end(static_cast<const char*>(std::memchr(data + i, '\n', size - i)));
+		i = end ? end - data + 1 : size;
+	}
+
+	size_t next(nextGame(i));
+
+	game.offset = offset;
+	game.tags = std::string_view(data + offset, i - offset);
+	game.movetext = std::string_view(data + i, next - i);
+
+	return next;
+}
+
+// Comments, variations, move numbers and annotation glyphs are skipped, the SAN moves are resolved on the board
+bool PgnReader::replay(const PgnGame& game, const std::function<void(const Game&, const Move&)>& callback, PgnError& error)
+{
+	std::string_view fen(game.tag("FEN"));
+	std::unique_ptr<Game> board;
+
+	try {
+		board.reset(fen.empty() ? new Game() : new Game(std::string(fen)));
+	} catch (const std::runtime_error& exception) {
+		error = { game.offset, 0, std::string(), exception.what() };
+		return false;
+	}
+
+	std::string_view text(game.movetext);
+	size_t i(0);
+	u16 ply(0);
+
+	while (i < text.size()) {
+		char c(text[i]);
+
+		if (isSpace(c) || c == '.' || c == ')') {
+			++i;
+		} else if (c == '{') {
+			i = std::min(text.find('}', i), text.size()) + 1;
+		} else if (c == ';' || (c == '%' && (!i || text[i - 1] == '\n'))) {
+			i = std::min(text.find('\n', i), text.size());
+		} else if (c == '(') {
+			// Variations, nested, may hold comments with parentheses
+			int depth(0);
+
+			for (; i < text.size(); ++i) {
+				if (text[i] == '{')
+					i = std::min(text.find('}', i), text.size() - 1);
+				else if (text[i] == '(')
+					++depth;
+				else if (text[i] == ')' && --depth == 0)
+					break;
+			}
+
+			++i;
+		} else {
+			size_t start(i);
+
+			while (i < text.size() && !isSpace(text[i]) && text[i] != '{' && text[i] != '(' && text[i] != ')' && text[i] != ';')
+				++i;
+
+			std::string_view token(text.substr(start, i - start));
+
+			if (c == '$')
+				continue;
+
+			if (isResult(token))
+				break;
+
+			// A move number, possibly followed by the move : 12. 12... 12.e4
+			if (c >= '1' && c <= '9') {
+				size_t digits(token.find_first_not_of("0123456789."));
+
+				if (digits == std::string_view::npos)
+					continue;
+
+				token.remove_prefix(digits);
+			}
+
+			Move move(resolve(*board, token));
+
+			if (move == Move()) {
+				error = { game.offset, ply, std::string(token), board->isOver() ? "move after the end of the game" : "illegal or ambiguous move" };
+				return false;
+			}
+
+			if (callback)
+				callback(*board, move);
+
+			board->makeMove(move);
+			++ply;
+		}
+	}
+
+	return true;
+}
+
+// The legal move of the SAN, or no move if there are none or several
+Move PgnReader::resolve(const Game& game, std::string_view san)
+{
+	while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?'))
+		san.remove_suffix(1);
+
+	const std::list<Move>& moves(game.possibleMoves());
+
+	if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+		MoveType type(san.size() == 3 ? KingCastle : QueenCastle);
+
+		for (const Move& move : moves) {
+			if (move.type() == type)
+				return move;
+		}
+
+		return Move();
+	}
+
+	static const std::string_view pieces("PNBRQK");
+
+	PieceType type(Pawn), promotion(Pawn);
+	size_t begin(0), end(san.size());
+
+	if (end && san[0] >= 'B' && san[0] <= 'R' && pieces.find(san[0]) != std::string_view::npos) {
+		type = PieceType(pieces.find(san[0]));
+		begin = 1;
+	}
+
+	// e8=Q, or e8Q
+	if (end >= 2 && type == Pawn && pieces.find(san[end - 1]) != std::string_view::npos) {
+		promotion = PieceType(pieces.find(san[end - 1]));
+		end -= san[end - 2] == '=' ? 2 : 1;
+	}
+
+	if (end < begin + 2 || san[end - 2] < 'a' || san[end - 2] > 'h' || san[end - 1] < '1' || san[end - 1] > '8')
+		return Move();
+
+	u8 to(u8(8 * (san[end - 1] - '1') + san[end - 2] - 'a'));
+	int file(-1), rank(-1);
+
+	for (size_t i(begin); i < end - 2; ++i) {
+		if (san[i] >= 'a' && san[i] <= 'h')
+			file = san[i] - 'a';
+		else if (san[i] >= '1' && san[i] <= '8')
+			rank = san[i] - '1';
+		else if (san[i] != 'x' && san[i] != ':' && san[i] != '-')
+			return Move();
+	}
+
+	Move result;
+	u8 count(0);
+
+	for (const Move& move : moves) {
+		if (move.to() != to || move.isCastle() || game.pieceType(move.from()) != type)
+			continue;
+
+		if ((file >= 0 && move.from() % 8 != file) || (rank >= 0 && move.from() / 8 != rank))
+			continue;
+
+		// A pawn capture names the file of the pawn : b5 is only a push, never axb5
+		if (type == Pawn && file < 0 && move.from() % 8 != to % 8)
+			continue;
+
+		if (move.isPromotion() != (promotion != Pawn) || (promotion != Pawn && move.promotionType() != promotion))
+			continue;
+
+		result = move;
+		++count;
+	}
+
+	return count == 1 ? result : Move();
+}
@@ -0,0 +1,47 @@
+#ifndef PGNREADER_H
+#define PGNREADER_H
+
+#include "Game.h"
+#include "MappedFile.h"
+
+// A game of a PGN file : views into the mapped file, valid while it is open
+struct PgnGame
+{
+	std::string_view tag(std::string_view) const;
+
+	u64 offset;                // Of the first byte of the game in the file
+	std::string_view tags;
+	std::string_view movetext;
+};
+
+struct PgnError
+{
+	u64 offset;
+	u16 ply;                   // Of the move which could not be played
+	std::string move;
+	std::string reason;
+};
+
+// Games of a mapped PGN file, by byte offsets : the file can be split in ranges read by different threads, each game
+// belonging to the range of its first byte. A game starts with a tag line after a blank line, or at the start.
+class PgnReader
+{
+public:
+	bool open(const std::string&);
+	void close();
+
+	size_t size() const;
+
+	size_t nextGame(size_t) const;
+	size_t read(size_t, PgnGame&) const;
+
+	// Plays the moves of the game from its start position, calling back before each move
+	static bool replay(const PgnGame&, const std::function<void(const Game&, const Move&)>&, PgnError&);
+
+	static Move resolve(const Game&, std::string_view);
+
+private:
+	MappedFile mFile;
+};
+
+#endif // PGNREADER_H
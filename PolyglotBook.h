@@ -0,0 +1,45 @@
+#ifndef POLYGLOTBOOK_H
+#define POLYGLOTBOOK_H
+
+#include "Game.h"
+#include "MappedFile.h"
+
+struct BookEntry
+{
+	Move move;
+	u16 weight;
+};
+
+// Polyglot opening book (.bin) : 16-byte big-endian entries sorted by position key, probed in the mapped file.
+// The keys use the 781 Random64 constants of the Polyglot format, unrelated to the keys of Hashing, checked against
+// the test keys of the format.
+class PolyglotBook
+{
+public:
+	PolyglotBook();
+
+	bool open(const std::string&);
+	void close();
+
+	bool isOpen() const;
+
+	static u64 key(const Game&);
+
+	std::vector<BookEntry> entries(const Game&) const;
+	Move probe(const Game&);
+
+private:
+	static const size_t sEntrySize;
+	static const std::pair<const char*, u64> sTestKeys[];
+
+	static u64 _readBigEndian(const u8*, u8);
+
+	static bool _checkKeys();
+	Move _move(const Game&, u16) const;
+
+	MappedFile mFile;
+
+	std::mt19937 mGenerator;
+};
+
+#endif // POLYGLOTBOOK_H
@@ -0,0 +1,255 @@
+#include "PositionDatabase.h"
+
+const u64 PositionDatabase::sMagic = 0x3142445350534843; // "CHSPSDB1"
+
+static u16 moveCode(const Move& move)
+{
+	return u16(move.type() << 12 | move.from() << 6 | move.to());
+}
+
+PositionDatabase::PositionDatabase() :
+	mRecords(nullptr),
+	mSize(0),
+	mGenerator(std::random_device()())
+{
+}
+
+// The header is the magic number and the number of records
+bool PositionDatabase::open(const std::string& path)
+{
+	close();
+
+	if (!mFile.open(path))
+		return false;
+
+	u64 header[2];
+
+	if (mFile.size() < sizeof(header)) {
+		close();
+		return false;
+	}
+
+	std::memcpy(header, mFile.data(), sizeof(header));
+
+	if (header[0] != sMagic || mFile.size() != sizeof(header) + header[1] * sizeof(PositionRecord)) {
+		close();
+		return false;
+	}
+
+	mRecords = reinterpret_cast<const PositionRecord*>(mFile.data() + sizeof(header));
+	mSize = header[1];
+
+	return true;
+}
+
+void PositionDatabase::close()
+{
+	mFile.close();
+	mRecords = nullptr;
+	mSize = 0;
+}
+
+bool PositionDatabase::isOpen() const
+{
+	return mRecords != nullptr;
+}
+
+u64 PositionDatabase::size() const
+{
+	return mSize;
+}
+
+// The legal moves recorded for the position, the most played first
+std::vector<PositionMove> PositionDatabase::moves(const Game& game) const
+{
+	std::vector<PositionMove> moves;
+
+	if (!isOpen())
+		return moves;
+
+	u64 key(game.hash());
+	const PositionRecord* record(std::lower_bound(mRecords, mRecords + mSize, key, [](const PositionRecord& r, u64 k) { return r.key < k; }));
+
+	for (; record != mRecords + mSize && record->key == key; ++record) {
+		for (const Move& move : game.possibleMoves()) {
+			if (moveCode(move) == record->move) {
+				moves.push_back({ move, record->results });
+				break;
+			}
+		}
+	}
+
+	std::sort(moves.begin(), moves.end(), [](const PositionMove& m1, const PositionMove& m2) {
+		return m1.results[0] + m1.results[1] + m1.results[2] > m2.results[0] + m2.results[1] + m2.results[2];
+	});
+
+	return moves;
+}
+
+// A move picked with a probability proportional to 2 wins + draws for the side to move, as the weights of a
+// Polyglot book, or the null move out of the database
+Move PositionDatabase::probe(const Game& game)
+{
+	std::vector<PositionMove> candidates(moves(game));
+	size_t win(game.activePlayer() == White ? 0 : 2);
+	u64 total(0);
+
+	for (const PositionMove& candidate : candidates)
+		total += 2 * u64(candidate.results[win]) + candidate.results[1];
+
+	if (!total)
+		return Move();
+
+	u64 pick(std::uniform_int_distribution<u64>(0, total - 1)(mGenerator));
+
+	for (const PositionMove& candidate : candidates) {
+		u64 weight(2 * u64(candidate.results[win]) + candidate.results[1]);
+
+		if (pick < weight)
+			return candidate.move;
+
+		pick -= weight;
+	}
+
+	return Move();
+}
+
+PositionDatabaseBuilder::PositionDatabaseBuilder(const std::string& path) :
+	mPath(path)
+{
+}
+
+PositionDatabaseBuilder::~PositionDatabaseBuilder()
+{
+	for (const std::string& run : mRuns)
+		std::remove(run.c_str());
+}
+
+// Thread safe : the records are sorted and merged by the calling thread, the vector is emptied
+void PositionDatabaseBuilder::addRun(std::vector<PositionRecord>& records)
+{
+	if (records.empty())
+		return;
+
+	_merge(records);
+
+	std::string path;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		path = mPath + ".run" + std::to_string(mRuns.size());
+		mRuns.push_back(path);
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(PositionRecord));
+
+	if (!file)
+		throw std::runtime_error("cannot write " + path);
+
+	records.clear();
+}
+
+// Merge of the runs, by blocks of each : returns the number of records of the database
+u64 PositionDatabaseBuilder::finish()
+{
+	static const size_t sBlockSize = 1 << 14;
+
+	struct Run
+	{
+		std::ifstream file;
+		std::vector<PositionRecord> block;
+		size_t next;
+
+		bool refill()
+		{
+			block.resize(sBlockSize);
+			file.read(reinterpret_cast<char*>(block.data()), sBlockSize * sizeof(PositionRecord));
+			block.resize(size_t(file.gcount()) / sizeof(PositionRecord));
+			next = 0;
+
+			return !block.empty();
+		}
+	};
+
+	std::vector<Run> runs(mRuns.size());
+	std::vector<size_t> heap;
+
+	// Min-heap of the runs by their next record
+	auto isAfter([&runs](size_t r1, size_t r2) { return _isBefore(runs[r2].block[runs[r2].next], runs[r1].block[runs[r1].next]); });
+
+	for (size_t i(0); i < runs.size(); ++i) {
+		runs[i].file.open(mRuns[i], std::ios::binary);
+
+		if (runs[i].refill())
+			heap.push_back(i);
+	}
+
+	std::make_heap(heap.begin(), heap.end(), isAfter);
+
+	std::ofstream file(mPath, std::ios::binary | std::ios::trunc);
+	u64 header[2] = { PositionDatabase::sMagic, 0 };
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	std::vector<PositionRecord> output;
+	output.reserve(sBlockSize);
+
+	while (!heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end(), isAfter);
+		Run& run(runs[heap.back()]);
+		const PositionRecord& record(run.block[run.next]);
+
+		if (!output.empty() && output.back().key == record.key && output.back().move == record.move) {
+			for (size_t i(0); i < 3; ++i)
+				output.back().results[i] += record.results[i];
+		} else {
+			// The last record may still be merged with the next one
+			if (output.size() == sBlockSize) {
+				file.write(reinterpret_cast<const char*>(output.data()), (output.size() - 1) * sizeof(PositionRecord));
+				header[1] += output.size() - 1;
+				output.erase(output.begin(), output.end() - 1);
+			}
+
+			output.push_back(record);
+		}
+
+		if (++run.next < run.block.size() || run.refill())
+			std::push_heap(heap.begin(), heap.end(), isAfter);
+		else
+			heap.pop_back();
+	}
+
+	file.write(reinterpret_cast<const char*>(output.data()), output.size() * sizeof(PositionRecord));
+	header[1] += output.size();
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	if (!file)
+		throw std::runtime_error("cannot write " + mPath);
+
+	return header[1];
+}
+
+bool PositionDatabaseBuilder::_isBefore(const PositionRecord& r1, const PositionRecord& r2)
+{
+	return r1.key < r2.key || (r1.key == r2.key && r1.move < r2.move);
+}
+
+// Sorts the records and adds up those of the same position and move
+void PositionDatabaseBuilder::_merge(std::vector<PositionRecord>& records)
+{
+	std::sort(records.begin(), records.end(), _isBefore);
+
+	size_t size(0);
+
+	for (size_t i(0); i < records.size(); ++i) {
+		if (size && records[size - 1].key == records[i].key && records[size - 1].move == records[i].move) {
+			for (size_t j(0); j < 3; ++j)
+				records[size - 1].results[j] += records[i].results[j];
+		} else
+			records[size++] = records[i];
+	}
+
+	records.resize(size);
+}
@@ -0,0 +1,72 @@
+#ifndef POSITIONDATABASE_H
+#define POSITIONDATABASE_H
+
+#include "Game.h"
+#include "MappedFile.h"
+
+// Statistics of the moves played from each position of a game archive, in a file of records sorted by key then move,
+// after a header. The keys are Game::hash(), the same on every build since the Zobrist keys are fixed.
+struct PositionRecord
+{
+	u64 key;
+	u16 move;                   // Move code : type << 12 | from << 6 | to
+	u16 reserved;
+	std::array<std::uint32_t, 3> results; // Games won by White, drawn, won by Black : u32 is 64 bits wide on Linux
+};
+
+static_assert(sizeof(PositionRecord) == 24, "a position record must fit in 24 bytes");
+
+struct PositionMove
+{
+	Move move;
+	std::array<std::uint32_t, 3> results;
+};
+
+class PositionDatabase
+{
+public:
+	PositionDatabase();
+
+	bool open(const std::string&);
+	void close();
+
+	bool isOpen() const;
+	u64 size() const;
+
+	std::vector<PositionMove> moves(const Game&) const;
+	Move probe(const Game&);
+
+private:
+	static const u64 sMagic;
+
+	const PositionRecord* mRecords;
+	u64 mSize;
+
+	MappedFile mFile;
+	std::mt19937 mGenerator;
+
+	friend class PositionDatabaseBuilder;
+};
+
+// External sort : the records are added by sorted runs written next to the database, then merged into it, so that
+// the memory used only depends on the size of the runs
+class PositionDatabaseBuilder
+{
+public:
+	PositionDatabaseBuilder(const std::string&);
+	~PositionDatabaseBuilder();
+
+	void addRun(std::vector<PositionRecord>&);
+	u64 finish();
+
+private:
+	static bool _isBefore(const PositionRecord&, const PositionRecord&);
+	static void _merge(std::vector<PositionRecord>&);
+
+	std::string mPath;
+	std::vector<std::string> mRuns;
+
+	std::mutex mMutex;
+};
+
+#endif // POSITIONDATABASE_H
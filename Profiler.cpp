@@ -0,0 +1,37 @@
+#include "Profiler.h"
+
+#ifdef CHESS_PROFILE
+
+const std::array<std::string, ProfiledSectionsCount> Profiler::sNames = { "Move generation", "Legality filter", "Make move", "Unmake move", "Evaluation", "TT probe", "Move ordering" };
+
+thread_local std::array<Profiler::Counter, ProfiledSectionsCount> Profiler::sCounters = {};
+thread_local u64 Profiler::sBegin = 0;
+
+void Profiler::reset()
+{
+	sCounters.fill({ 0, 0 });
+	sBegin = __rdtsc();
+}
+
+// Breakdown of the cycles spent by the calling thread since the last reset
+void Profiler::report(std::ostream& stream)
+{
+	u64 total(std::max<u64>(__rdtsc() - sBegin, 1));
+	char line[128];
+
+	snprintf(line, sizeof(line), "%-18s %14s %16s %12s %8s\n", "Section", "Calls", "Cycles", "Cycles/call", "Total");
+	stream << line;
+
+	for (u8 i(0); i < ProfiledSectionsCount; ++i) {
+		const Counter& counter(sCounters[i]);
+
+		snprintf(line, sizeof(line), "%-18s %14llu %16llu %12.1f %7.1f%%\n", sNames[i].c_str(), counter.calls, counter.cycles,
+			counter.calls ? double(counter.cycles) / double(counter.calls) : 0., 100. * double(counter.cycles) / double(total));
+		stream << line;
+	}
+
+	snprintf(line, sizeof(line), "%-18s %14s %16llu\n", "Total", "", total);
+	stream << line;
+}
+
+#endif // CHESS_PROFILE
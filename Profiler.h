@@ -0,0 +1,78 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "defs.h"
+
+// Cycle-level profiling of the hot paths, compiled out unless CHESS_PROFILE is defined.
+// The timers are inclusive : a make/unmake done by the legality filter also counts in the legality filter.
+
+#ifdef CHESS_PROFILE
+
+#ifndef _MSC_VER
+#include <x86intrin.h>
+#endif
+
+enum ProfiledSection {
+	MoveGeneration,
+	LegalityFilter,
+	MakeMove,
+	UnmakeMove,
+	Evaluation,
+	TTProbe,
+	MoveOrdering,
+	ProfiledSectionsCount
+};
+
+// The counters are per thread : no contention between searching threads
+class Profiler
+{
+public:
+	static void reset();
+	static void report(std::ostream&);
+
+	static void add(ProfiledSection section, u64 cycles)
+	{
+		sCounters[section].cycles += cycles;
+		++sCounters[section].calls;
+	}
+
+private:
+	struct Counter
+	{
+		u64 cycles;
+		u64 calls;
+	};
+
+	static const std::array<std::string, ProfiledSectionsCount> sNames;
+
+	static thread_local std::array<Counter, ProfiledSectionsCount> sCounters;
+	static thread_local u64 sBegin;
+};
+
+class ScopedTimer
+{
+public:
+	ScopedTimer(ProfiledSection section) : mSection(section), mBegin(__rdtsc()) {}
+	~ScopedTimer() { Profiler::add(mSection, __rdtsc() - mBegin); }
+
+private:
+	ProfiledSection mSection;
+	u64 mBegin;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#define PROFILE_SCOPE(section) ScopedTimer PROFILE_CONCAT(scopedTimer, __LINE__)(section)
+#define PROFILE_RESET() Profiler::reset()
+#define PROFILE_REPORT(stream) Profiler::report(stream)
+
+#else
+
+#define PROFILE_SCOPE(section)
+#define PROFILE_RESET()
+#define PROFILE_REPORT(stream)
+
+#endif // CHESS_PROFILE
+
+#endif // PROFILER_H
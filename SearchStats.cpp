@@ -0,0 +1,85 @@
+#include "SearchStats.h"
+
+SearchStats::SearchStats()
+{
+	clear();
+}
+
+void SearchStats::clear()
+{
+	time = 0;
+	nodes = 0;
+	qnodes = 0;
+
+	iterations.clear();
+
+	ttProbes = 0;
+	ttHits = 0;
+	ttCutoffs = 0;
+
+	betaCutoffs = 0;
+	firstMoveCutoffs = 0;
+
+	standPatCutoffs = 0;
+	seePrunings = 0;
+
+	tbProbes = 0;
+	tbHits = 0;
+	tbCacheHits = 0;
+}
+
+double SearchStats::firstMoveCutoffRate() const
+{
+	return betaCutoffs ? double(firstMoveCutoffs) / double(betaCutoffs) : 0;
+}
+
+// Geometric mean of the growth of the node count from one iteration to the next
+double SearchStats::branchingFactor() const
+{
+	u8 n(0);
+	double product(1);
+
+	for (size_t i(1); i < iterations.size(); ++i) {
+		u64 previous(iterations[i - 1].nodes - (i > 1 ? iterations[i - 2].nodes : 0)),
+			current(iterations[i].nodes - iterations[i - 1].nodes);
+
+		if (!previous || !current)
+			continue;
+
+		product *= double(current) / double(previous);
+		++n;
+	}
+
+	return n ? std::pow(product, 1. / n) : 0;
+}
+
+// A single line JSON object, so that the stats of successive searches can be appended as JSON lines
+std::string SearchStats::toJson() const
+{
+	std::ostringstream json;
+
+	json << "{\"time\":" << time << ",\"nodes\":" << nodes << ",\"qnodes\":" << qnodes
+		 << ",\"tt\":{\"probes\":" << ttProbes << ",\"hits\":" << ttHits << ",\"cutoffs\":" << ttCutoffs << "}"
+		 << ",\"betaCutoffs\":" << betaCutoffs << ",\"firstMoveCutoffRate\":" << firstMoveCutoffRate()
+		 << ",\"branchingFactor\":" << branchingFactor()
+		 << ",\"pruning\":{\"standPat\":" << standPatCutoffs << ",\"see\":" << seePrunings << "}"
+		 << ",\"tb\":{\"probes\":" << tbProbes << ",\"hits\":" << tbHits << ",\"cacheHits\":" << tbCacheHits << "}"
+		 << ",\"iterations\":[";
+
+	for (size_t i(0); i < iterations.size(); ++i) {
+		const IterationStats& iteration(iterations[i]);
+
+		json << (i ? "," : "") << "{\"depth\":" << int(iteration.depth) << ",\"time\":" << iteration.time
+			 << ",\"nodes\":" << iteration.nodes << ",\"qnodes\":" << iteration.qnodes << ",\"score\":" << iteration.score
+			 << ",\"pv\":\"";
+
+		for (std::list<Move>::const_iterator it(iteration.principalVariation.begin()); it != iteration.principalVariation.end(); ++it)
+			json << (it == iteration.principalVariation.begin() ? "" : " ") << it->toString();
+
+		json << "\"}";
+	}
+
+	json << "]}";
+
+	return json.str();
+}
@@ -0,0 +1,55 @@
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+#include "Move.h"
+
+struct IterationStats
+{
+	u8 depth;
+	u64 time;     // ms, since the beginning of the search
+	u64 nodes;    // Since the beginning of the search
+	u64 qnodes;   // Quiescence nodes, since the beginning of the search
+	double score; // For the side to move
+
+	std::list<Move> principalVariation;
+
+	u8 line;      // Rank of the line in MultiPV mode, from 1
+};
+
+struct SearchStats
+{
+	SearchStats();
+
+	void clear();
+
+	double firstMoveCutoffRate() const;
+	double branchingFactor() const;
+
+	std::string toJson() const;
+
+	u64 time;
+	u64 nodes;
+	u64 qnodes;
+
+	std::vector<IterationStats> iterations;
+
+	// Transposition table
+	u64 ttProbes;
+	u64 ttHits;
+	u64 ttCutoffs;
+
+	// Beta cutoffs in the main search, and those produced by the first move searched
+	u64 betaCutoffs;
+	u64 firstMoveCutoffs;
+
+	// Pruning
+	u64 standPatCutoffs;
+	u64 seePrunings;
+
+	// Endgame tablebases : WDL probes in the search, those answered, and those answered by the probe cache
+	u64 tbProbes;
+	u64 tbHits;
+	u64 tbCacheHits;
+};
+
+#endif // SEARCHSTATS_H
@@ -0,0 +1,127 @@
+#include "SearchTrace.h"
+
+#ifdef CHESS_TRACE_SEARCH
+
+std::atomic<bool> SearchTrace::sOpen(false);
+std::mutex SearchTrace::sMutex;
+std::vector<std::unique_ptr<TraceBuffer>> SearchTrace::sBuffers;
+std::ofstream SearchTrace::sFile;
+std::thread SearchTrace::sWriter;
+
+thread_local TraceBuffer* SearchTrace::sBuffer = nullptr;
+
+TraceBuffer::TraceBuffer(u16 thread) :
+	mRecords(sCapacity),
+	mHead(0),
+	mTail(0),
+	mThread(thread)
+{
+}
+
+// When the writer falls behind, the search waits for it rather than losing records
+void TraceBuffer::push(const TraceRecord& record)
+{
+	u64 head(mHead.load(std::memory_order_relaxed));
+
+	while (head - mTail.load(std::memory_order_acquire) >= sCapacity)
+		std::this_thread::yield();
+
+	mRecords[head % sCapacity] = record;
+	mHead.store(head + 1, std::memory_order_release);
+}
+
+void TraceBuffer::drain(std::ostream& stream)
+{
+	u64 tail(mTail.load(std::memory_order_relaxed));
+	u64 head(mHead.load(std::memory_order_acquire));
+
+	if (head == tail)
+		return;
+
+	TraceChunkHeader header({ mThread, 0, std::uint32_t(head - tail) });
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	// The pending records may wrap around the end of the buffer
+	u64 begin(tail % sCapacity), end(begin + (head - tail));
+
+	if (end <= sCapacity)
+		stream.write(reinterpret_cast<const char*>(&mRecords[begin]), (end - begin) * sizeof(TraceRecord));
+	else {
+		stream.write(reinterpret_cast<const char*>(&mRecords[begin]), (sCapacity - begin) * sizeof(TraceRecord));
+		stream.write(reinterpret_cast<const char*>(&mRecords[0]), (end - sCapacity) * sizeof(TraceRecord));
+	}
+
+	mTail.store(head, std::memory_order_release);
+}
+
+bool SearchTrace::open(const std::string& path)
+{
+	close();
+
+	sFile.open(path, std::ios::binary | std::ios::trunc);
+
+	if (!sFile)
+		return false;
+
+	std::uint32_t recordSize(sizeof(TraceRecord));
+
+	sFile.write(sTraceMagic, sizeof(sTraceMagic));
+	sFile.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+
+	sOpen = true;
+	sWriter = std::thread(&SearchTrace::_write);
+
+	return true;
+}
+
+void SearchTrace::close()
+{
+	if (!sOpen)
+		return;
+
+	sOpen = false;
+	sWriter.join();
+	sFile.close();
+}
+
+void SearchTrace::record(TraceRecordType type, const Move& move, u8 ply, u8 depth, double alpha, double beta, double score, u8 flags)
+{
+	_buffer().push({ float(alpha), float(beta), float(score), encodeTraceMove(move), ply, depth, u8(type), flags, 0 });
+}
+
+// Each thread gets its buffer on its first record, the buffers live until the end of the program
+TraceBuffer& SearchTrace::_buffer()
+{
+	if (sBuffer == nullptr) {
+		std::lock_guard<std::mutex> lock(sMutex);
+
+		sBuffers.emplace_back(new TraceBuffer(u16(sBuffers.size())));
+		sBuffer = sBuffers.back().get();
+	}
+
+	return *sBuffer;
+}
+
+// Writer thread : drains the buffers until the trace is closed, then a last time
+void SearchTrace::_write()
+{
+	bool isOpen(true);
+
+	while (isOpen) {
+		isOpen = sOpen;
+
+		{
+			std::lock_guard<std::mutex> lock(sMutex);
+
+			for (std::unique_ptr<TraceBuffer>& buffer : sBuffers)
+				buffer->drain(sFile);
+		}
+
+		if (isOpen)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	sFile.flush();
+}
+
+#endif // CHESS_TRACE_SEARCH
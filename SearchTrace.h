@@ -0,0 +1,120 @@
+#ifndef SEARCHTRACE_H
+#define SEARCHTRACE_H
+
+#include "Move.h"
+
+// Binary trace of the search tree, compiled out unless CHESS_TRACE_SEARCH is defined.
+// Every node is recorded when it returns : the records of a search are in post-order, and with their ply they
+// are enough to rebuild the tree offline (see trace_main.cpp). The file format does not depend on the switch.
+
+enum TraceRecordType {
+	TraceIteration,
+	TracePVSNode,
+	TraceQuiescenceNode
+};
+
+enum TraceFlag {
+	TraceHashHit = 1,
+	TraceHashCutoff = 2,
+	TraceInterrupted = 4
+};
+
+// Scores and window are from the point of view of the side to move at the node
+struct TraceRecord
+{
+	float alpha;
+	float beta;
+	float score;
+	std::uint16_t move;
+	std::uint8_t ply;
+	std::uint8_t depth;
+	std::uint8_t type;
+	std::uint8_t flags;
+	std::uint16_t reserved;
+};
+
+static_assert(sizeof(TraceRecord) == 20, "a trace record must fit in 20 bytes");
+
+// The file starts with the magic and the record size on 4 bytes, followed by chunks : a thread index, a record count
+// and the records
+struct TraceChunkHeader
+{
+	std::uint16_t thread;
+	std::uint16_t reserved;
+	std::uint32_t count;
+};
+
+static_assert(sizeof(TraceChunkHeader) == 8, "a trace chunk header must fit in 8 bytes");
+
+static const char sTraceMagic[4] = { 'C', 'T', 'R', 'C' };
+
+inline u16 encodeTraceMove(const Move& move)
+{
+	return u16(move.type() << 12 | move.from() << 6 | move.to());
+}
+
+inline Move decodeTraceMove(u16 move)
+{
+	return Move((move >> 6) & 0x3F, move & 0x3F, MoveType(move >> 12));
+}
+
+#ifdef CHESS_TRACE_SEARCH
+
+// Preallocated ring buffer, with the searching thread as its only producer and the writer thread as its only consumer
+class TraceBuffer
+{
+public:
+	TraceBuffer(u16);
+
+	void push(const TraceRecord&);
+	void drain(std::ostream&);
+
+private:
+	static const u64 sCapacity = 1 << 16;
+
+	std::vector<TraceRecord> mRecords;
+	std::atomic<u64> mHead;
+	std::atomic<u64> mTail;
+
+	u16 mThread;
+};
+
+class SearchTrace
+{
+public:
+	// Neither open nor close may be called while a search is running
+	static bool open(const std::string&);
+	static void close();
+
+	static bool isOpen()
+	{
+		return sOpen.load(std::memory_order_relaxed);
+	}
+
+	static void record(TraceRecordType, const Move&, u8, u8, double, double, double, u8);
+
+private:
+	static TraceBuffer& _buffer();
+	static void _write();
+
+	static std::atomic<bool> sOpen;
+	static std::mutex sMutex;
+	static std::vector<std::unique_ptr<TraceBuffer>> sBuffers;
+	static std::ofstream sFile;
+	static std::thread sWriter;
+
+	static thread_local TraceBuffer* sBuffer;
+};
+
+#define TRACE_NODE(type, move, ply, depth, alpha, beta, score, flags) \
+	do { if (SearchTrace::isOpen()) SearchTrace::record(type, move, ply, depth, alpha, beta, score, flags); } while (false)
+#define TRACE_WINDOW(alpha, beta) const double traceAlpha(alpha), traceBeta(beta)
+
+#else
+
+#define TRACE_NODE(type, move, ply, depth, alpha, beta, score, flags)
+#define TRACE_WINDOW(alpha, beta)
+
+#endif // CHESS_TRACE_SEARCH
+
+#endif // SEARCHTRACE_H
@@ -0,0 +1,982 @@
+#include "Tablebases.h"
+
+// Decoding follows the reference Syzygy probing code : the tables are split by side to move and by file of the
+// leading pawn, each position is encoded to an index, and the values are Huffman coded "recursive pairs" in blocks.
+
+const size_t Tablebases::sCacheSize = 1 << 16;
+const i8 Tablebases::sFailedProbe = 127;
+
+std::array<std::array<u64, 64>, 6> Tablebases::sBinomial;
+std::array<std::array<u64, 64>, 6> Tablebases::sLeadPawnIndex;
+std::array<std::array<u64, 4>, 6> Tablebases::sLeadPawnsSize;
+std::array<u8, 64> Tablebases::sMapPawns;
+std::array<u8, 64> Tablebases::sMapB1H1H7;
+std::array<u8, 64> Tablebases::sMapA1D1D4;
+std::array<std::array<u16, 64>, 10> Tablebases::sMapKK;
+
+namespace
+{
+	enum TableFlag {
+		SideToMoveFlag = 1,
+		MappedFlag = 2,
+		WinPliesFlag = 4,
+		LossPliesFlag = 8,
+		WideFlag = 16,
+		SingleValueFlag = 128
+	};
+
+	const std::array<std::array<u8, 4>, 2> sMagics = { { { 0x71, 0xE8, 0x23, 0x5D }, { 0xD7, 0x66, 0x0C, 0xA5 } } };
+	const std::array<std::string, 2> sExtensions = { ".rtbw", ".rtbz" };
+	const std::string sPieceLetters("PNBRQK");
+
+	// Rank minus file : 0 on the a1-h8 diagonal, negative below
+	int offDiagonal(u8 square)
+	{
+		return int(square >> 3) - int(square & 7);
+	}
+
+	u64 readLittleEndian(const u8* data, u8 size)
+	{
+		u64 value(0);
+
+		for (u8 i(size); i > 0; --i)
+			value = value << 8 | data[i - 1];
+
+		return value;
+	}
+
+	u64 readBigEndian(const u8* data, u8 size)
+	{
+		u64 value(0);
+
+		for (u8 i(0); i < size; ++i)
+			value = value << 8 | data[i];
+
+		return value;
+	}
+
+	// A symbol of the btree is made of two 12-bit symbols
+	u16 leftSymbol(const PairsData& d, u16 symbol)
+	{
+		const u8* pair(d.btree + 3 * symbol);
+		return u16((pair[1] & 0xF) << 8 | pair[0]);
+	}
+
+	u16 rightSymbol(const PairsData& d, u16 symbol)
+	{
+		const u8* pair(d.btree + 3 * symbol);
+		return u16(pair[2] << 4 | pair[1] >> 4);
+	}
+
+	const u8* alignTo(const u8* data, uintptr_t alignment)
+	{
+		return reinterpret_cast<const u8*>((reinterpret_cast<uintptr_t>(data) + alignment - 1) & ~(alignment - 1));
+	}
+}
+
+Tablebases::Tablebases() :
+	mMaxPieces(0),
+	mCache(sCacheSize)
+{
+	_initIndexTables();
+}
+
+// Directories separated by ':' (';' on Windows), scanned for .rtbw and .rtbz files
+bool Tablebases::init(const std::string& paths)
+{
+	clear();
+
+#ifdef _WIN32
+	const char separator(';');
+#else
+	const char separator(':');
+#endif
+
+	std::istringstream stream(paths);
+	std::string directory;
+
+	while (std::getline(stream, directory, separator)) {
+		std::error_code error;
+
+		for (const std::filesystem::directory_entry& file : std::filesystem::directory_iterator(directory, error)) {
+			std::string extension(file.path().extension().string());
+
+			for (u8 type(WDLTable); type <= DTZTable; ++type)
+				if (extension == sExtensions[type])
+					_addTable(file.path().stem().string(), file.path().string(), TablebaseType(type));
+		}
+	}
+
+	for (const std::unique_ptr<TablebaseTable>& table : mTables)
+		if (!table->paths[WDLTable].empty())
+			mMaxPieces = std::max(mMaxPieces, table->piecesCount);
+
+	return mMaxPieces > 0;
+}
+
+void Tablebases::clear()
+{
+	mTables.clear();
+	mTablesByName.clear();
+	mTablesByKey.clear();
+	mMaxPieces = 0;
+
+	std::fill(mCache.begin(), mCache.end(), CacheEntry({ 0, 0 }));
+}
+
+u8 Tablebases::maxPieces() const
+{
+	return mMaxPieces;
+}
+
+// The tables know nothing of castling, and of the fifty-move counter : their results are exact right after a reset
+bool Tablebases::canProbe(const Game& game) const
+{
+	return mMaxPieces && !game.castlingRights() && !game.halfmoveClock() && popcount(game.occupancy()) <= mMaxPieces;
+}
+
+// WDL of the position from the point of view of the side to move, through a cache of the recent probes
+bool Tablebases::probeWdl(Game* game, WDLScore& wdl, bool& isCacheHit)
+{
+	CacheEntry& entry(mCache[game->hash() % sCacheSize]);
+
+	isCacheHit = entry.hash == game->hash();
+
+	if (!isCacheHit) {
+		ProbeState state(ProbeOk);
+		WDLScore score(_probeWdl(game, state));
+
+		entry = { game->hash(), state == ProbeFailed ? sFailedProbe : i8(score) };
+	}
+
+	if (entry.wdl == sFailedProbe)
+		return false;
+
+	wdl = WDLScore(entry.wdl);
+
+	return true;
+}
+
+// DTZ of the position from the point of view of the side to move, without cache : see _probeDtz
+bool Tablebases::probeDtz(Game* game, int& dtz)
+{
+	ProbeState state(ProbeOk);
+
+	dtz = _probeDtz(game, state);
+
+	return state != ProbeFailed;
+}
+
+// DTZ-optimal move : the fastest safe conversion of a win, the longest resistance in a loss, a drawing move otherwise.
+// Returns the null move if a table is missing.
+Move Tablebases::probeRoot(const Game& root)
+{
+	if (!mMaxPieces || root.castlingRights() || popcount(root.occupancy()) > mMaxPieces)
+		return Move();
+
+	Game game(root);
+	ProbeState state(ProbeOk);
+
+	Move bestMove;
+	int bestRank(-1000000);
+	int halfmoveClock(root.halfmoveClock());
+
+	for (const Move& move : root.possibleMoves()) {
+		game.makeMove(move);
+
+		int dtz(0);
+
+		// After a zeroing move, the DTZ is one of -101, -1, 0, 1, 101
+		if (!game.halfmoveClock())
+			dtz = _dtzBeforeZeroing(WDLScore(-_probeWdl(&game, state)));
+		else {
+			dtz = -_probeDtz(&game, state);
+			dtz = dtz > 0 ? dtz + 1 : dtz < 0 ? dtz - 1 : dtz;
+		}
+
+		if (dtz == 2 && game.isKingInCheck(game.activePlayer()) && !game.hasLegalMoves())
+			dtz = 1;
+
+		game.unmakeMove();
+
+		if (state == ProbeFailed)
+			return Move();
+
+		// Wins that the fifty-move rule turns into draws come after the real wins, same for the losses
+		int rank(0);
+
+		if (dtz > 0)
+			rank = dtz + halfmoveClock <= 99 ? 2000 - dtz : 1000 - (dtz + halfmoveClock);
+		else if (dtz < 0)
+			rank = -dtz * 2 + halfmoveClock < 100 ? -2000 - dtz : -1000 + (-dtz + halfmoveClock);
+
+		if (rank > bestRank) {
+			bestRank = rank;
+			bestMove = move;
+		}
+	}
+
+	return bestMove;
+}
+
+void Tablebases::_initIndexTables()
+{
+	static bool isInitialized(false);
+
+	if (isInitialized)
+		return;
+
+	isInitialized = true;
+
+	// Squares below the a1-h8 diagonal to 0..27
+	u8 code(0);
+
+	for (u8 square(0); square < 64; ++square)
+		if (offDiagonal(square) < 0)
+			sMapB1H1H7[square] = code++;
+
+	// Squares of the a1-d1-d4 triangle to 0..9, the diagonal ones last
+	std::vector<u8> diagonal;
+	code = 0;
+
+	for (u8 square(0); square <= 27; ++square) {
+		if (offDiagonal(square) < 0 && (square & 7) <= 3)
+			sMapA1D1D4[square] = code++;
+		else if (!offDiagonal(square) && (square & 7) <= 3)
+			diagonal.push_back(square);
+	}
+
+	for (u8 square : diagonal)
+		sMapA1D1D4[square] = code++;
+
+	// The 462 legal placements of two kings with the first one in the a1-d1-d4 triangle.
+	// If the first king is on the diagonal, the second one is not above it; both on the diagonal come last.
+	std::vector<std::pair<u8, u8>> bothOnDiagonal;
+	u16 kingsCode(0);
+
+	for (u8 index(0); index < 10; ++index) {
+		for (u8 first(0); first <= 27; ++first) {
+			if (sMapA1D1D4[first] != index || (!index && first != 1))
+				continue;
+
+			for (u8 second(0); second < 64; ++second) {
+				if ((MoveGenerator::instance().kingMoves(first) | u64(1) << first) & u64(1) << second)
+					continue;
+				else if (!offDiagonal(first) && offDiagonal(second) > 0)
+					continue;
+				else if (!offDiagonal(first) && !offDiagonal(second))
+					bothOnDiagonal.push_back(std::make_pair(index, second));
+				else
+					sMapKK[index][second] = kingsCode++;
+			}
+		}
+	}
+
+	for (const std::pair<u8, u8>& kings : bothOnDiagonal)
+		sMapKK[kings.first][kings.second] = kingsCode++;
+
+	// sBinomial[k][n] : ways to choose k squares among n
+	sBinomial[0][0] = 1;
+
+	for (u8 n(1); n < 64; ++n)
+		for (u8 k(0); k < 6 && k <= n; ++k)
+			sBinomial[k][n] = (k > 0 ? sBinomial[k - 1][n - 1] : 0) + (k < n ? sBinomial[k][n - 1] : 0);
+
+	// sMapPawns maps a2-h7 to 0..47 : the leading pawn is the one with the highest value, nearest to the edge then
+	// lowest. The tables are split by file of the leading pawn, so the index restarts on each file.
+	u8 availableSquares(47);
+
+	for (u8 leadPawnsCount(1); leadPawnsCount <= 5; ++leadPawnsCount) {
+		for (u8 file(0); file <= 3; ++file) {
+			u64 index(0);
+
+			for (u8 rank(1); rank <= 6; ++rank) {
+				u8 square(8 * rank + file);
+
+				if (leadPawnsCount == 1) {
+					sMapPawns[square] = availableSquares--;
+					sMapPawns[square ^ 7] = availableSquares--;
+				}
+
+				sLeadPawnIndex[leadPawnsCount][square] = index;
+				index += sBinomial[leadPawnsCount - 1][sMapPawns[square]];
+			}
+
+			sLeadPawnsSize[leadPawnsCount][file] = index;
+		}
+	}
+}
+
+// Counts of each piece type of each player on 4 bits
+u64 Tablebases::_materialKey(const std::array<std::array<u8, 6>, 2>& counts)
+{
+	u64 key(0);
+
+	for (u8 player(White); player <= Black; ++player)
+		for (u8 type(Pawn); type <= King; ++type)
+			key |= u64(counts[player][type]) << (4 * (6 * player + type));
+
+	return key;
+}
+
+u64 Tablebases::_materialKey(const Game& game)
+{
+	std::array<std::array<u8, 6>, 2> counts;
+
+	for (u8 player(White); player <= Black; ++player)
+		for (u8 type(Pawn); type <= King; ++type)
+			counts[player][type] = popcount(game.piecesOf(Player(player), PieceType(type)));
+
+	return _materialKey(counts);
+}
+
+int Tablebases::_dtzBeforeZeroing(WDLScore wdl)
+{
+	return wdl == WDLWin ? 1 : wdl == WDLCursedWin ? 101 : wdl == WDLBlessedLoss ? -101 : wdl == WDLLoss ? -1 : 0;
+}
+
+// Table names list the pieces of the stronger side first : KRPvKR
+void Tablebases::_addTable(const std::string& name, const std::string& path, TablebaseType type)
+{
+	std::map<std::string, TablebaseTable*>::iterator it(mTablesByName.find(name));
+
+	if (it != mTablesByName.end()) {
+		it->second->paths[type] = path;
+		return;
+	}
+
+	size_t separator(name.find('v'));
+
+	if (separator == std::string::npos)
+		return;
+
+	std::array<std::array<u8, 6>, 2> counts = {};
+	u8 piecesCount(0);
+
+	for (size_t i(0); i < name.size(); ++i) {
+		if (i == separator)
+			continue;
+
+		size_t type(sPieceLetters.find(name[i]));
+
+		if (type == std::string::npos)
+			return;
+
+		++counts[i > separator][type];
+		++piecesCount;
+	}
+
+	if (counts[White][King] != 1 || counts[Black][King] != 1 || piecesCount > 7)
+		return;
+
+	std::unique_ptr<TablebaseTable> table(new TablebaseTable());
+
+	table->paths[type] = path;
+	table->isLoaded = { false, false };
+	table->isValid = { false, false };
+	table->key = _materialKey(counts);
+	table->key2 = _materialKey({ counts[Black], counts[White] });
+	table->piecesCount = piecesCount;
+	table->hasPawns = counts[White][Pawn] || counts[Black][Pawn];
+	table->hasUniquePieces = false;
+	table->dtzMap = nullptr;
+
+	for (u8 player(White); player <= Black; ++player)
+		for (u8 pieceType(Pawn); pieceType < King; ++pieceType)
+			if (counts[player][pieceType] == 1)
+				table->hasUniquePieces = true;
+
+	// With pawns on both sides, the leading color is the one with less pawns
+	bool isWhiteLeading(!counts[Black][Pawn] || (counts[White][Pawn] && counts[Black][Pawn] >= counts[White][Pawn]));
+
+	table->pawnsCount[0] = counts[isWhiteLeading ? White : Black][Pawn];
+	table->pawnsCount[1] = counts[isWhiteLeading ? Black : White][Pawn];
+
+	mTablesByName[name] = table.get();
+	mTablesByKey[table->key] = table.get();
+	mTablesByKey[table->key2] = table.get();
+	mTables.push_back(std::move(table));
+}
+
+// Maps the file and reads the decoding data once, on the first probe
+bool Tablebases::_load(TablebaseTable& table, TablebaseType type)
+{
+	if (table.isLoaded[type])
+		return table.isValid[type];
+
+	table.isLoaded[type] = true;
+
+	if (table.paths[type].empty() || !table.files[type].open(table.paths[type]))
+		return false;
+
+	const u8* data(table.files[type].data());
+
+	if (table.files[type].size() % 64 != 16 || !std::equal(sMagics[type].begin(), sMagics[type].end(), data)) {
+		std::cerr << "Corrupted tablebase file " << table.paths[type] << "\n";
+		table.files[type].close();
+		return false;
+	}
+
+	_setup(table, type, data + 4);
+	table.isValid[type] = true;
+
+	return true;
+}
+
+void Tablebases::_setup(TablebaseTable& table, TablebaseType type, const u8* data)
+{
+	// The first byte holds flags : split by side to move, pawns
+	++data;
+
+	u8 sides(type == WDLTable && table.key != table.key2 ? 2 : 1);
+	u8 maxFile(table.hasPawns ? 3 : 0);
+	bool hasPawnsOnBothSides(table.hasPawns && table.pawnsCount[1]);
+
+	for (u8 file(0); file <= maxFile; ++file) {
+		for (u8 side(0); side < sides; ++side)
+			table.pairs[type][side][file] = PairsData();
+
+		std::array<std::array<u8, 2>, 2> order = { {
+			{ u8(data[0] & 0xF), u8(hasPawnsOnBothSides ? data[1] & 0xF : 0xF) },
+			{ u8(data[0] >> 4), u8(hasPawnsOnBothSides ? data[1] >> 4 : 0xF) }
+		} };
+
+		data += 1 + hasPawnsOnBothSides;
+
+		for (u8 k(0); k < table.piecesCount; ++k, ++data)
+			for (u8 side(0); side < sides; ++side)
+				table.pairs[type][side][file].pieces[k] = side ? *data >> 4 : *data & 0xF;
+
+		for (u8 side(0); side < sides; ++side)
+			_setGroups(table, table.pairs[type][side][file], order[side], file);
+	}
+
+	data = alignTo(data, 2);
+
+	for (u8 file(0); file <= maxFile; ++file)
+		for (u8 side(0); side < sides; ++side)
+			data = _setSizes(table.pairs[type][side][file], data);
+
+	if (type == DTZTable)
+		data = _setDtzMap(table, data, maxFile);
+
+	for (u8 file(0); file <= maxFile; ++file) {
+		for (u8 side(0); side < sides; ++side) {
+			table.pairs[type][side][file].sparseIndex = data;
+			data += table.pairs[type][side][file].sparseIndexSize * 6;
+		}
+	}
+
+	for (u8 file(0); file <= maxFile; ++file) {
+		for (u8 side(0); side < sides; ++side) {
+			table.pairs[type][side][file].blockLengths = data;
+			data += table.pairs[type][side][file].blockLengthsSize * 2;
+		}
+	}
+
+	for (u8 file(0); file <= maxFile; ++file) {
+		for (u8 side(0); side < sides; ++side) {
+			data = alignTo(data, 64);
+			table.pairs[type][side][file].data = data;
+			data += table.pairs[type][side][file].blocksCount * table.pairs[type][side][file].blockSize;
+		}
+	}
+}
+
+// Pieces are encoded by groups : the leading pawns or pieces, the other pawns, then each set of identical pieces.
+// The order of the groups in the index is a parameter of each table.
+void Tablebases::_setGroups(const TablebaseTable& table, PairsData& d, const std::array<u8, 2>& order, u8 file)
+{
+	int n(0), firstLength(table.hasPawns ? 0 : table.hasUniquePieces ? 3 : 2);
+
+	d.groupLength[n] = 1;
+
+	for (u8 i(1); i < table.piecesCount; ++i) {
+		if (--firstLength > 0 || d.pieces[i] == d.pieces[i - 1])
+			++d.groupLength[n];
+		else
+			d.groupLength[++n] = 1;
+	}
+
+	d.groupLength[++n] = 0;
+
+	bool hasPawnsOnBothSides(table.hasPawns && table.pawnsCount[1]);
+	int next(hasPawnsOnBothSides ? 2 : 1);
+	int freeSquares(64 - d.groupLength[0] - (hasPawnsOnBothSides ? d.groupLength[1] : 0));
+	u64 index(1);
+
+	for (int k(0); next < n || k == order[0] || k == order[1]; ++k) {
+		if (k == order[0]) {
+			d.groupIndex[0] = index;
+			index *= table.hasPawns ? sLeadPawnsSize[d.groupLength[0]][file] : table.hasUniquePieces ? 31332 : 462;
+		} else if (k == order[1]) {
+			d.groupIndex[1] = index;
+			index *= sBinomial[d.groupLength[1]][48 - d.groupLength[0]];
+		} else {
+			d.groupIndex[next] = index;
+			index *= sBinomial[d.groupLength[next]][freeSquares];
+			freeSquares -= d.groupLength[next++];
+		}
+	}
+
+	d.groupIndex[n] = index;
+}
+
+const u8* Tablebases::_setSizes(PairsData& d, const u8* data)
+{
+	d.flags = *data++;
+
+	// The whole table holds a single value, stored instead of the minimum symbol length
+	if (d.flags & SingleValueFlag) {
+		d.blocksCount = 0;
+		d.span = 0;
+		d.blockLengthsSize = 0;
+		d.sparseIndexSize = 0;
+		d.minSymbolLength = *data++;
+
+		return data;
+	}
+
+	// The last group index is the size of the table
+	u64 size(d.groupIndex[std::find(d.groupLength.begin(), d.groupLength.begin() + 7, 0) - d.groupLength.begin()]);
+
+	d.blockSize = u64(1) << *data++;
+	d.span = u64(1) << *data++;
+	d.sparseIndexSize = (size + d.span - 1) / d.span;
+
+	u8 padding(*data++);
+
+	d.blocksCount = u32(readLittleEndian(data, 4));
+	data += 4;
+
+	d.blockLengthsSize = d.blocksCount + padding;
+	d.maxSymbolLength = *data++;
+	d.minSymbolLength = *data++;
+	d.lowestSymbols = data;
+	d.base.assign(d.maxSymbolLength - d.minSymbolLength + 1, 0);
+
+	// Canonical Huffman code : longer symbols have lower values. base[i] is the lowest code of length
+	// i + minSymbolLength, left aligned on 64 bits, so that base[i] >= base[i + 1].
+	for (int i(int(d.base.size()) - 2); i >= 0; --i)
+		d.base[i] = (d.base[i + 1] + readLittleEndian(d.lowestSymbols + 2 * i, 2) - readLittleEndian(d.lowestSymbols + 2 * (i + 1), 2)) / 2;
+
+	for (size_t i(0); i < d.base.size(); ++i)
+		d.base[i] <<= 64 - i - d.minSymbolLength;
+
+	data += d.base.size() * 2;
+
+	d.symbolLengths.assign(readLittleEndian(data, 2), 0);
+	data += 2;
+
+	d.btree = data;
+
+	std::vector<bool> visited(d.symbolLengths.size());
+
+	for (u16 symbol(0); symbol < d.symbolLengths.size(); ++symbol)
+		if (!visited[symbol])
+			d.symbolLengths[symbol] = _symbolLength(d, symbol, visited);
+
+	return data + 3 * d.symbolLengths.size() + (d.symbolLengths.size() & 1);
+}
+
+// DTZ values may be remapped per WDL result, through bytes or 16-bit words
+const u8* Tablebases::_setDtzMap(TablebaseTable& table, const u8* data, u8 maxFile)
+{
+	table.dtzMap = data;
+
+	for (u8 file(0); file <= maxFile; ++file) {
+		PairsData& d(table.pairs[DTZTable][0][file]);
+
+		if (!(d.flags & MappedFlag))
+			continue;
+
+		if (d.flags & WideFlag) {
+			data = alignTo(data, 2);
+
+			for (u8 i(0); i < 4; ++i) {
+				d.mapIndex[i] = u16((data - table.dtzMap) / 2 + 1);
+				data += 2 * readLittleEndian(data, 2) + 2;
+			}
+		} else {
+			for (u8 i(0); i < 4; ++i) {
+				d.mapIndex[i] = u16(data - table.dtzMap + 1);
+				data += *data + 1;
+			}
+		}
+	}
+
+	return alignTo(data, 2);
+}
+
+// Number of values, minus one, a symbol stands for : symbols are pairs of symbols down to the leaves
+u8 Tablebases::_symbolLength(PairsData& d, u16 symbol, std::vector<bool>& visited)
+{
+	visited[symbol] = true;
+
+	u16 right(rightSymbol(d, symbol));
+
+	if (right == 0xFFF)
+		return 0;
+
+	u16 left(leftSymbol(d, symbol));
+
+	if (!visited[left])
+		d.symbolLengths[left] = _symbolLength(d, left, visited);
+
+	if (!visited[right])
+		d.symbolLengths[right] = _symbolLength(d, right, visited);
+
+	return d.symbolLengths[left] + d.symbolLengths[right] + 1;
+}
+
+int Tablebases::_decompress(const PairsData& d, u64 index) const
+{
+	if (d.flags & SingleValueFlag)
+		return d.minSymbolLength;
+
+	// The sparse index points near the block of the index, the block lengths give the exact one
+	u64 k(index / d.span);
+	u32 block(u32(readLittleEndian(d.sparseIndex + 6 * k, 4)));
+	i64 offset(i64(readLittleEndian(d.sparseIndex + 6 * k + 4, 2)));
+
+	offset += i64(index % d.span) - i64(d.span / 2);
+
+	while (offset < 0)
+		offset += i64(readLittleEndian(d.blockLengths + 2 * --block, 2)) + 1;
+
+	while (offset > i64(readLittleEndian(d.blockLengths + 2 * block, 2)))
+		offset -= i64(readLittleEndian(d.blockLengths + 2 * block++, 2)) + 1;
+
+	const u8* pointer(d.data + u64(block) * d.blockSize);
+
+	u64 buffer(readBigEndian(pointer, 8));
+	int bufferSize(64);
+	u16 symbol(0);
+
+	pointer += 8;
+
+	// Decode symbols until the one containing the offset
+	while (true) {
+		size_t length(0);
+
+		while (buffer < d.base[length])
+			++length;
+
+		symbol = u16((buffer - d.base[length]) >> (64 - length - d.minSymbolLength));
+		symbol += u16(readLittleEndian(d.lowestSymbols + 2 * length, 2));
+
+		if (offset < i64(d.symbolLengths[symbol]) + 1)
+			break;
+
+		offset -= i64(d.symbolLengths[symbol]) + 1;
+		length += d.minSymbolLength;
+		buffer <<= length;
+		bufferSize -= int(length);
+
+		if (bufferSize <= 32) {
+			bufferSize += 32;
+			buffer |= readBigEndian(pointer, 4) << (64 - bufferSize);
+			pointer += 4;
+		}
+	}
+
+	// Then walk down the pairs to the value
+	while (d.symbolLengths[symbol]) {
+		u16 left(leftSymbol(d, symbol));
+
+		if (offset < i64(d.symbolLengths[left]) + 1)
+			symbol = left;
+		else {
+			offset -= i64(d.symbolLengths[left]) + 1;
+			symbol = rightSymbol(d, symbol);
+		}
+	}
+
+	return leftSymbol(d, symbol);
+}
+
+// DTZ in plies, plus one
+int Tablebases::_mapDtz(const TablebaseTable& table, u8 file, int value, WDLScore wdl) const
+{
+	static const std::array<u8, 5> wdlMap = { 1, 3, 0, 2, 0 };
+
+	const PairsData& d(table.pairs[DTZTable][0][file]);
+
+	if (d.flags & MappedFlag) {
+		u64 index(d.mapIndex[wdlMap[wdl + 2]] + value);
+
+		value = d.flags & WideFlag ? int(readLittleEndian(table.dtzMap + 2 * index, 2)) : table.dtzMap[index];
+	}
+
+	if ((wdl == WDLWin && !(d.flags & WinPliesFlag)) || (wdl == WDLLoss && !(d.flags & LossPliesFlag)) || wdl == WDLCursedWin || wdl == WDLBlessedLoss)
+		value *= 2;
+
+	return value + 1;
+}
+
+int Tablebases::_probeTable(const Game& game, TablebaseType type, WDLScore wdl, ProbeState& state)
+{
+	// KvK
+	if (popcount(game.occupancy()) == 2)
+		return 0;
+
+	std::map<u64, TablebaseTable*>::iterator it(mTablesByKey.find(_materialKey(game)));
+
+	if (it == mTablesByKey.end() || !_load(*it->second, type)) {
+		state = ProbeFailed;
+		return 0;
+	}
+
+	return _probeTable(game, *it->second, type, wdl, state);
+}
+
+int Tablebases::_probeTable(const Game& game, TablebaseTable& table, TablebaseType type, WDLScore wdl, ProbeState& state)
+{
+	std::array<u8, 7> squares, pieces;
+	int next(0), size(0), leadPawnsCount(0);
+	u64 index(0), leadPawns(0), b(0);
+	u8 file(0);
+
+	// The tables are computed with white as the stronger side, and symmetric ones only with white to move :
+	// otherwise the colors are swapped and the board flipped.
+	bool isBlackSymmetric(game.activePlayer() == Black && table.key == table.key2);
+	bool isBlackStronger(_materialKey(game) != table.key);
+	bool isFlipped(isBlackSymmetric || isBlackStronger);
+
+	u8 flipColor(isFlipped * 8), flipSquares(isFlipped * 56);
+	u8 sideToMove(isFlipped ^ game.activePlayer());
+
+	auto pawnsCompare = [](u8 a, u8 b) { return sMapPawns[a] < sMapPawns[b]; };
+
+	// With pawns, the table is split by the file of the leading pawn, the one nearest to the edge
+	if (table.hasPawns) {
+		u8 piece(table.pairs[type][0][0].pieces[0] ^ flipColor);
+
+		leadPawns = b = game.piecesOf(Player(piece >> 3), Pawn);
+
+		do
+			squares[size++] = bsfReset(b) ^ flipSquares;
+		while (b);
+
+		leadPawnsCount = size;
+
+		std::swap(squares[0], *std::max_element(squares.begin(), squares.begin() + leadPawnsCount, pawnsCompare));
+
+		file = squares[0] & 7;
+
+		if (file > 3)
+			file = (squares[0] ^ 7) & 7;
+	}
+
+	// The DTZ tables only store one side to move
+	if (type == DTZTable && (table.pairs[DTZTable][0][file].flags & SideToMoveFlag) != sideToMove && !(table.key == table.key2 && !table.hasPawns)) {
+		state = ProbeChangeSideToMove;
+		return 0;
+	}
+
+	b = game.occupancy() ^ leadPawns;
+
+	do {
+		u8 square(bsfReset(b));
+
+		squares[size] = square ^ flipSquares;
+		pieces[size++] = u8(((game.player(Black) >> square & 1) << 3 | (game.pieceType(square) + 1)) ^ flipColor);
+	} while (b);
+
+	const PairsData& d(table.pairs[type][type == WDLTable ? sideToMove : 0][file]);
+
+	// Same piece order as the table
+	for (int i(leadPawnsCount); i < size - 1; ++i) {
+		for (int j(i + 1); j < size; ++j) {
+			if (d.pieces[i] == pieces[j]) {
+				std::swap(pieces[i], pieces[j]);
+				std::swap(squares[i], squares[j]);
+				break;
+			}
+		}
+	}
+
+	// The leading piece goes to the a-d files
+	if ((squares[0] & 7) > 3)
+		for (int i(0); i < size; ++i)
+			squares[i] ^= 7;
+
+	if (table.hasPawns) {
+		index = sLeadPawnIndex[leadPawnsCount][squares[0]];
+
+		std::stable_sort(squares.begin() + 1, squares.begin() + leadPawnsCount, pawnsCompare);
+
+		for (int i(1); i < leadPawnsCount; ++i)
+			index += sBinomial[i][sMapPawns[squares[i]]];
+	} else {
+		// Without pawns, the leading piece also goes to the ranks 1-4, then below the a1-h8 diagonal
+		if ((squares[0] >> 3) > 3)
+			for (int i(0); i < size; ++i)
+				squares[i] ^= 56;
+
+		for (int i(0); i < d.groupLength[0]; ++i) {
+			if (!offDiagonal(squares[i]))
+				continue;
+
+			if (offDiagonal(squares[i]) > 0)
+				for (int j(i); j < size; ++j)
+					squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+
+			break;
+		}
+
+		// Three unique pieces are encoded together, otherwise the two kings
+		if (table.hasUniquePieces) {
+			u64 adjust1(squares[1] > squares[0]);
+			u64 adjust2((squares[2] > squares[0]) + (squares[2] > squares[1]));
+
+			if (offDiagonal(squares[0]))
+				index = (sMapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+			else if (offDiagonal(squares[1]))
+				index = (6 * 63 + (squares[0] >> 3) * 28 + sMapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+			else if (offDiagonal(squares[2]))
+				index = 6 * 63 * 62 + 4 * 28 * 62 + (squares[0] >> 3) * 7 * 28 + ((squares[1] >> 3) - adjust1) * 28 + sMapB1H1H7[squares[2]];
+			else
+				index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + (squares[0] >> 3) * 7 * 6 + ((squares[1] >> 3) - adjust1) * 6 + ((squares[2] >> 3) - adjust2);
+		} else
+			index = sMapKK[sMapA1D1D4[squares[0]]][squares[1]];
+	}
+
+	// The other groups, each one with its squares in ascending order, skipping the squares of the previous groups
+	index *= d.groupIndex[0];
+
+	u8* groupSquares(squares.data() + d.groupLength[0]);
+	bool hasRemainingPawns(table.hasPawns && table.pawnsCount[1]);
+
+	while (d.groupLength[++next]) {
+		std::stable_sort(groupSquares, groupSquares + d.groupLength[next]);
+
+		u64 n(0);
+
+		for (int i(0); i < d.groupLength[next]; ++i) {
+			u8 square(groupSquares[i]);
+			int adjust(int(std::count_if(squares.data(), groupSquares, [square](u8 s) { return square > s; })));
+
+			n += sBinomial[i + 1][square - adjust - 8 * hasRemainingPawns];
+		}
+
+		hasRemainingPawns = false;
+		index += n * d.groupIndex[next];
+		groupSquares += d.groupLength[next];
+	}
+
+	int value(_decompress(d, index));
+
+	return type == WDLTable ? value - 2 : _mapDtz(table, file, value, wdl);
+}
+
+// The tables do not hold the positions where a capture is best, nor en passant : the captures (and the pawn moves
+// for DTZ) are searched first, the table only for the rest.
+WDLScore Tablebases::_search(Game* game, bool checkZeroingMoves, ProbeState& state)
+{
+	WDLScore value(WDLLoss), bestValue(WDLLoss);
+	size_t movesCount(0), totalCount(game->possibleMoves().size());
+
+	for (const Move& move : game->possibleMoves()) {
+		if (!move.isCapture() && (!checkZeroingMoves || game->pieceType(move.from()) != Pawn))
+			continue;
+
+		++movesCount;
+
+		game->makeMove(move);
+		value = WDLScore(-_search(game, false, state));
+		game->unmakeMove();
+
+		if (state == ProbeFailed)
+			return WDLDraw;
+
+		if (value > bestValue) {
+			bestValue = value;
+
+			if (value >= WDLWin) {
+				state = ProbeZeroingBestMove;
+				return value;
+			}
+		}
+	}
+
+	// Once all the moves are searched, the table is useless
+	bool hasNoMoreMoves(movesCount && movesCount == totalCount);
+
+	if (hasNoMoreMoves)
+		value = bestValue;
+	else {
+		value = WDLScore(_probeTable(*game, WDLTable, WDLDraw, state));
+
+		if (state == ProbeFailed)
+			return WDLDraw;
+	}
+
+	// The DTZ table stores a "don't care" value when a zeroing move is as good
+	if (bestValue >= value) {
+		state = bestValue > WDLDraw || hasNoMoreMoves ? ProbeZeroingBestMove : ProbeOk;
+		return bestValue;
+	}
+
+	state = ProbeOk;
+
+	return value;
+}
+
+WDLScore Tablebases::_probeWdl(Game* game, ProbeState& state)
+{
+	state = ProbeOk;
+	return _search(game, false, state);
+}
+
+// Plies to the next capture or pawn move of the winning side, negative when losing, 0 for a draw.
+// Plus 100 for the cursed wins and blessed losses.
+int Tablebases::_probeDtz(Game* game, ProbeState& state)
+{
+	state = ProbeOk;
+
+	WDLScore wdl(_search(game, true, state));
+
+	if (state == ProbeFailed || wdl == WDLDraw)
+		return 0;
+
+	if (state == ProbeZeroingBestMove)
+		return _dtzBeforeZeroing(wdl);
+
+	int dtz(_probeTable(*game, DTZTable, wdl, state));
+
+	if (state == ProbeFailed)
+		return 0;
+
+	if (state != ProbeChangeSideToMove)
+		return (dtz + 100 * (wdl == WDLBlessedLoss || wdl == WDLCursedWin)) * (wdl > 0 ? 1 : -1);
+
+	// The table stores the other side to move : one ply search for the best DTZ
+	int minDtz(0xFFFF);
+
+	for (const Move& move : game->possibleMoves()) {
+		bool isZeroing(move.isCapture() || game->pieceType(move.from()) == Pawn);
+
+		game->makeMove(move);
+
+		// For a zeroing move, the DTZ is the one before the move, with the sign of the position after it
+		dtz = isZeroing ? -_dtzBeforeZeroing(_search(game, false, state)) : -_probeDtz(game, state);
+
+		if (dtz == 1 && game->isKingInCheck(game->activePlayer()) && !game->hasLegalMoves())
+			minDtz = 1;
+
+		if (!isZeroing)
+			dtz += dtz > 0 ? 1 : dtz < 0 ? -1 : 0;
+
+		if (dtz < minDtz && (dtz > 0) == (wdl > 0) && dtz)
+			minDtz = dtz;
+
+		game->unmakeMove();
+
+		if (state == ProbeFailed)
+			return 0;
+	}
+
+	// Without legal moves, the position is mate
+	return minDtz == 0xFFFF ? -1 : minDtz;
+}
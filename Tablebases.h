@@ -0,0 +1,141 @@
+#ifndef TABLEBASES_H
+#define TABLEBASES_H
+
+#include "Game.h"
+#include "MappedFile.h"
+
+enum WDLScore {
+	WDLLoss = -2,
+	WDLBlessedLoss = -1, // Loss, but a draw under the fifty-move rule
+	WDLDraw = 0,
+	WDLCursedWin = 1,    // Win, but a draw under the fifty-move rule
+	WDLWin = 2
+};
+
+enum ProbeState {
+	ProbeFailed,
+	ProbeOk,
+	ProbeZeroingBestMove,  // The best move is a capture or a pawn move, its DTZ is not stored
+	ProbeChangeSideToMove  // The DTZ table only stores the other side to move
+};
+
+enum TablebaseType {
+	WDLTable,
+	DTZTable
+};
+
+// Decoding data of a table for one side to move and one file of the leading pawn, pointing into the mapped file
+struct PairsData
+{
+	u8 flags;
+	u8 maxSymbolLength;
+	u8 minSymbolLength;
+	u32 blocksCount;
+	u64 blockSize;
+	u64 span;
+	u32 blockLengthsSize;
+	u64 sparseIndexSize;
+
+	const u8* lowestSymbols;
+	const u8* btree;
+	const u8* blockLengths;
+	const u8* sparseIndex;
+	const u8* data;
+
+	std::vector<u64> base;
+	std::vector<u8> symbolLengths;
+
+	std::array<u8, 7> pieces;
+	std::array<u64, 8> groupIndex;
+	std::array<u8, 8> groupLength;
+	std::array<u16, 4> mapIndex;
+};
+
+// A material configuration such as KRPvKR, with its WDL and DTZ files mapped on the first probe
+struct TablebaseTable
+{
+	std::array<std::string, 2> paths;
+	std::array<MappedFile, 2> files;
+	std::array<bool, 2> isLoaded;
+	std::array<bool, 2> isValid;
+
+	u64 key;
+	u64 key2;
+	u8 piecesCount;
+	bool hasPawns;
+	bool hasUniquePieces;
+	std::array<u8, 2> pawnsCount;
+
+	std::array<std::array<std::array<PairsData, 4>, 2>, 2> pairs;
+	const u8* dtzMap;
+};
+
+// Syzygy endgame tablebases. Like the transposition table, it is not thread safe.
+// The search only probes them when CHESS_SEARCH_TABLEBASES is defined, until the decoding is checked on real tables
+// with tbcheck.
+class Tablebases
+{
+public:
+	Tablebases();
+
+	bool init(const std::string&);
+	void clear();
+
+	u8 maxPieces() const;
+	bool canProbe(const Game&) const;
+
+	bool probeWdl(Game*, WDLScore&, bool&);
+	bool probeDtz(Game*, int&);
+	Move probeRoot(const Game&);
+
+private:
+	struct CacheEntry
+	{
+		u64 hash;
+		i8 wdl;
+	};
+
+	static const size_t sCacheSize;
+	static const i8 sFailedProbe;
+
+	static std::array<std::array<u64, 64>, 6> sBinomial;
+	static std::array<std::array<u64, 64>, 6> sLeadPawnIndex;
+	static std::array<std::array<u64, 4>, 6> sLeadPawnsSize;
+	static std::array<u8, 64> sMapPawns;
+	static std::array<u8, 64> sMapB1H1H7;
+	static std::array<u8, 64> sMapA1D1D4;
+	static std::array<std::array<u16, 64>, 10> sMapKK;
+
+	static void _initIndexTables();
+	static u64 _materialKey(const std::array<std::array<u8, 6>, 2>&);
+	static u64 _materialKey(const Game&);
+	static int _dtzBeforeZeroing(WDLScore);
+
+	void _addTable(const std::string&, const std::string&, TablebaseType);
+	bool _load(TablebaseTable&, TablebaseType);
+
+	void _setup(TablebaseTable&, TablebaseType, const u8*);
+	void _setGroups(const TablebaseTable&, PairsData&, const std::array<u8, 2>&, u8);
+	const u8* _setSizes(PairsData&, const u8*);
+	const u8* _setDtzMap(TablebaseTable&, const u8*, u8);
+	u8 _symbolLength(PairsData&, u16, std::vector<bool>&);
+
+	int _decompress(const PairsData&, u64) const;
+	int _mapDtz(const TablebaseTable&, u8, int, WDLScore) const;
+
+	int _probeTable(const Game&, TablebaseType, WDLScore, ProbeState&);
+	int _probeTable(const Game&, TablebaseTable&, TablebaseType, WDLScore, ProbeState&);
+
+	WDLScore _search(Game*, bool, ProbeState&);
+	WDLScore _probeWdl(Game*, ProbeState&);
+	int _probeDtz(Game*, ProbeState&);
+
+	std::vector<std::unique_ptr<TablebaseTable>> mTables;
+	std::map<std::string, TablebaseTable*> mTablesByName;
+	std::map<u64, TablebaseTable*> mTablesByKey;
+	u8 mMaxPieces;
+
+	std::vector<CacheEntry> mCache;
+};
+
+#endif // TABLEBASES_H
@@ -0,0 +1,165 @@
+#include "TimeManager.h"
+
+const u16 TimeManager::sPollInterval = 4096;
+const u16 TimeManager::sDefaultMovesToGo = 30;
+const u64 TimeManager::sMoveOverhead = 30;
+
+TimeManager::TimeManager() :
+	mSoftLimit(0),
+	mHardLimit(0),
+	mNodesLimit(0),
+	mHasTimeLimit(false),
+	mInfinite(false),
+	mIterationBegin(0),
+	mLastIterationTime(0),
+	mPreviousIterationTime(0),
+	mInstability(0),
+	mPollCountdown(sPollInterval),
+	mStop(false),
+	mPondering(false),
+	mPonderTime(0)
+{
+}
+
+void TimeManager::start(const SearchLimits& limits)
+{
+	mBegin = std::chrono::steady_clock::now();
+
+	mIterationBegin = 0;
+	mLastIterationTime = 0;
+	mPreviousIterationTime = 0;
+	mInstability = 0;
+
+	mPollCountdown = sPollInterval;
+	mStop = false;
+
+	mPonderTime = 0;
+	mPondering = limits.ponder;
+
+	mNodesLimit = limits.nodes;
+	mInfinite = limits.infinite;
+
+	// Without time information, only the other limits or the stop can end the search
+	mHasTimeLimit = limits.moveTime || limits.time;
+
+	if (!mHasTimeLimit)
+		return;
+
+	if (limits.moveTime) {
+		mSoftLimit = limits.moveTime;
+		mHardLimit = limits.moveTime;
+		return;
+	}
+
+	u64 available(limits.time > sMoveOverhead ? limits.time - sMoveOverhead : 1);
+	u16 movesToGo(limits.movesToGo ? std::min<u16>(limits.movesToGo, 50) : sDefaultMovesToGo);
+
+	// The soft limit is our share of the clock, the hard limit allows to finish an unstable iteration
+	mSoftLimit = std::min<u64>(available / movesToGo + 3 * limits.increment / 4, available);
+	mHardLimit = std::min<u64>(4 * mSoftLimit, movesToGo == 1 ? available : available / 3);
+	mHardLimit = std::max(mHardLimit, mSoftLimit);
+}
+
+void TimeManager::stop()
+{
+	mStop = true;
+}
+
+// Thread safe : the ponder move was played, the time spent so far is a gift and the limits start now.
+// Returns the time spent pondering, further calls have no effect.
+u64 TimeManager::ponderhit()
+{
+	if (isPondering()) {
+		mPonderTime = elapsed();
+		mPondering = false;
+	}
+
+	return mPonderTime;
+}
+
+u64 TimeManager::elapsed() const
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - mBegin).count();
+}
+
+u64 TimeManager::softLimit() const
+{
+	return mSoftLimit + mPonderTime;
+}
+
+u64 TimeManager::hardLimit() const
+{
+	return mHardLimit + mPonderTime;
+}
+
+bool TimeManager::isStopped() const
+{
+	return mStop.load(std::memory_order_relaxed);
+}
+
+bool TimeManager::isPondering() const
+{
+	return mPondering;
+}
+
+bool TimeManager::isInfinite() const
+{
+	return mInfinite;
+}
+
+// Called at every node : the clock is only read once every sPollInterval calls
+bool TimeManager::shouldStop(u64 nodes)
+{
+	if (isStopped())
+		return true;
+
+	if (mNodesLimit && nodes >= mNodesLimit && !isInfinite() && !isPondering()) {
+		mStop = true;
+		return true;
+	}
+
+	if (--mPollCountdown)
+		return false;
+
+	mPollCountdown = sPollInterval;
+
+	if (mHasTimeLimit && !isPondering() && !isInfinite() && elapsed() >= hardLimit())
+		mStop = true;
+
+	return isStopped();
+}
+
+void TimeManager::iterationDone(bool hasBestMoveChanged)
+{
+	u64 now(elapsed());
+
+	mPreviousIterationTime = mLastIterationTime;
+	mLastIterationTime = now - mIterationBegin;
+	mIterationBegin = now;
+
+	// A best move change gives more time, which decays as long as the best move is kept
+	mInstability = mInstability / 2 + hasBestMoveChanged;
+}
+
+bool TimeManager::canStartIteration() const
+{
+	if (isStopped())
+		return false;
+
+	// Without time limit, or while pondering, we deepen until another limit, the ponder hit or the stop
+	if (isPondering() || isInfinite() || !mHasTimeLimit)
+		return true;
+
+	u64 now(elapsed());
+
+	// The next iteration is predicted from the growth of the last two ones
+	double branchingFactor(4);
+
+	if (mPreviousIterationTime)
+		branchingFactor = std::min(std::max(double(mLastIterationTime) / double(mPreviousIterationTime), 1.5), 8.);
+
+	if (now + branchingFactor * mLastIterationTime > hardLimit())
+		return false;
+
+	return now < std::min<u64>(mPonderTime + mSoftLimit * (1 + mInstability), hardLimit());
+}
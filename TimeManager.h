@@ -0,0 +1,71 @@
+#ifndef TIMEMANAGER_H
+#define TIMEMANAGER_H
+
+#include "defs.h"
+
+struct SearchLimits
+{
+	SearchLimits() : time(0), increment(0), movesToGo(0), moveTime(0), depth(0), nodes(0), infinite(false), ponder(false) {};
+
+	u64 time;      // Remaining clock time of the side to move (ms)
+	u64 increment; // Increment per move (ms)
+	u16 movesToGo; // Moves until the next time control, 0 if sudden death
+
+	u64 moveTime;  // Fixed time for this move (ms), overrides the clock
+
+	u8 depth;      // Maximal depth, 0 if unlimited
+	u64 nodes;     // Maximal number of nodes, 0 if unlimited
+
+	bool infinite; // Search until stopped
+	bool ponder;   // Search on the opponent's time : the limits only apply after the ponder hit
+};
+
+class TimeManager
+{
+public:
+	TimeManager();
+
+	void start(const SearchLimits&);
+	void stop();
+	u64 ponderhit();
+
+	u64 elapsed() const;
+	u64 softLimit() const;
+	u64 hardLimit() const;
+
+	bool isStopped() const;
+	bool isPondering() const;
+	bool isInfinite() const;
+	bool shouldStop(u64);
+
+	void iterationDone(bool);
+	bool canStartIteration() const;
+
+private:
+	static const u16 sPollInterval;
+	static const u16 sDefaultMovesToGo;
+	static const u64 sMoveOverhead;
+
+	std::chrono::steady_clock::time_point mBegin;
+
+	u64 mSoftLimit;
+	u64 mHardLimit;
+	u64 mNodesLimit;
+
+	bool mHasTimeLimit;
+	bool mInfinite;
+
+	u64 mIterationBegin;
+	u64 mLastIterationTime;
+	u64 mPreviousIterationTime;
+
+	double mInstability;
+
+	u16 mPollCountdown;
+	std::atomic<bool> mStop;
+
+	std::atomic<bool> mPondering;
+	std::atomic<u64> mPonderTime;
+};
+
+#endif // TIMEMANAGER_H
@@ -0,0 +1,242 @@
+#include "TrainingData.h"
+
+const size_t TrainingWriter::sBlockSize = 16 << 20;
+
+void GameChain::start(const Game& game, u16 ply)
+{
+	mBoard.occupancy = game.occupancy();
+	mBoard.pieces.fill(0);
+
+	u64 occupancy(game.occupancy());
+
+	for (size_t i(0); occupancy; ++i) {
+		u8 square(bsfReset(occupancy));
+		u8 code(game.pieceType(square) + 6 * bool(game.player(Black) & (u64(1) << square)));
+
+		mBoard.pieces[i / 2] |= code << (4 * (i % 2));
+	}
+
+	mBoard.playerAndEnPassant = (game.activePlayer() == Black) << 7 | (game.enPassantSquare() == u8(-1) ? 64 : game.enPassantSquare());
+	mBoard.halfmoveClock = game.halfmoveClock();
+	mBoard.ply = ply;
+	mBoard.castlingRights = game.castlingRights();
+	mBoard.result = 1;
+	mBoard.reserved = 0;
+
+	mMoves.clear();
+}
+
+// Score in pawns for the side to move, clamped so that mates fit
+void GameChain::add(const Move& move, double score)
+{
+	mMoves.push_back({ u16(move.type() << 12 | move.from() << 6 | move.to()), i16(std::min(std::max(std::lround(100 * score), -32000l), 32000l)) });
+}
+
+void GameChain::finish(u8 result, std::vector<u8>& output)
+{
+	mBoard.result = result;
+
+	const u8* board(reinterpret_cast<const u8*>(&mBoard));
+	const u8* moves(reinterpret_cast<const u8*>(mMoves.data()));
+
+	output.insert(output.end(), board, board + sizeof(mBoard));
+	output.insert(output.end(), moves, moves + mMoves.size() * sizeof(ChainMove));
+	output.insert(output.end(), sizeof(ChainMove), 0);
+}
+
+size_t GameChain::size() const
+{
+	return mMoves.size();
+}
+
+TrainingWriter::TrainingWriter() :
+	mSize(0)
+{
+}
+
+TrainingWriter::~TrainingWriter()
+{
+	close();
+}
+
+bool TrainingWriter::open(const std::string& path)
+{
+	close();
+
+	mFile.open(path, std::ios::binary | std::ios::trunc);
+	mSize = 0;
+
+	return bool(mFile);
+}
+
+void TrainingWriter::close()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (!mFile.is_open())
+		return;
+
+	_flush();
+	mFile.close();
+}
+
+// Whole chains only, so that the chains of different threads do not interleave
+void TrainingWriter::write(const std::vector<u8>& chains)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mBuffer.insert(mBuffer.end(), chains.begin(), chains.end());
+	mSize += chains.size();
+
+	if (mBuffer.size() >= sBlockSize)
+		_flush();
+}
+
+u64 TrainingWriter::size() const
+{
+	return mSize;
+}
+
+void TrainingWriter::_flush()
+{
+	mFile.write(reinterpret_cast<const char*>(mBuffer.data()), mBuffer.size());
+	mBuffer.clear();
+}
+
+TrainingReader::TrainingReader() :
+	mOffset(0),
+	mIsValid(false),
+	mIsInChain(false)
+{
+}
+
+bool TrainingReader::open(const std::string& path)
+{
+	mOffset = 0;
+	mIsInChain = false;
+	mIsValid = mFile.open(path);
+
+	return mIsValid;
+}
+
+// Appends up to count positions, fewer at the end of the file or on corrupt data
+size_t TrainingReader::read(std::vector<TrainingPosition>& positions, size_t count)
+{
+	size_t read(0);
+
+	while (read < count && mIsValid) {
+		if (!mIsInChain && !_readBoard())
+			break;
+
+		if (mOffset + sizeof(ChainMove) > mFile.size()) {
+			mIsValid = false;
+			break;
+		}
+
+		ChainMove entry;
+		std::memcpy(&entry, mFile.data() + mOffset, sizeof(entry));
+		mOffset += sizeof(entry);
+
+		// No move has the code 0 : a1 to a1
+		if (!entry.move) {
+			mIsInChain = false;
+			continue;
+		}
+
+		mCurrent.score = entry.score;
+		positions.push_back(mCurrent);
+		++read;
+
+		_play(entry.move);
+	}
+
+	return read;
+}
+
+bool TrainingReader::isValid() const
+{
+	return mIsValid;
+}
+
+bool TrainingReader::_readBoard()
+{
+	if (mOffset == mFile.size())
+		return false;
+
+	if (mOffset + sizeof(PackedBoard) > mFile.size()) {
+		mIsValid = false;
+		return false;
+	}
+
+	PackedBoard board;
+	std::memcpy(&board, mFile.data() + mOffset, sizeof(board));
+	mOffset += sizeof(board);
+
+	PackedPosition& position(mCurrent.position);
+	u64 occupancy(board.occupancy);
+
+	position.players.fill(0);
+	position.pieces.fill(0);
+
+	for (size_t i(0); occupancy && i < 32; ++i) {
+		u8 square(bsfReset(occupancy));
+		u8 code((board.pieces[i / 2] >> (4 * (i % 2))) & 0xF);
+
+		if (code > 11) {
+			mIsValid = false;
+			return false;
+		}
+
+		position.players[code / 6] |= u64(1) << square;
+		position.pieces[code % 6] |= u64(1) << square;
+	}
+
+	mCurrent.activePlayer = Player(board.playerAndEnPassant >> 7);
+	mCurrent.result = board.result;
+	mIsInChain = true;
+
+	return true;
+}
+
+void TrainingReader::_play(u16 move)
+{
+	PackedPosition& position(mCurrent.position);
+	Player player(mCurrent.activePlayer), opponent(otherPlayer(player));
+
+	u8 from((move >> 6) & 0x3F), to(move & 0x3F);
+	MoveType type(MoveType(move >> 12));
+	u64 fromMask(u64(1) << from), toMask(u64(1) << to);
+
+	u8 pieceType(Pawn);
+
+	while (pieceType < King && !(position.pieces[pieceType] & fromMask))
+		++pieceType;
+
+	if (position.players[opponent] & toMask) {
+		for (u64& pieces : position.pieces)
+			pieces &= ~toMask;
+
+		position.players[opponent] &= ~toMask;
+	}
+
+	if (type == EnPassant) {
+		u64 captured(player == White ? toMask >> 8 : toMask << 8);
+
+		position.pieces[Pawn] &= ~captured;
+		position.players[opponent] &= ~captured;
+	}
+
+	position.pieces[pieceType] &= ~fromMask;
+	position.pieces[type >= KnightPromo ? Knight + (type & 3) : pieceType] |= toMask;
+	position.players[player] ^= fromMask | toMask;
+
+	if (type == KingCastle || type == QueenCastle) {
+		u8 rank(player == White ? 0 : 56);
+		u64 rookMask((u64(1) << (rank + (type == KingCastle ? 7 : 0))) | (u64(1) << (rank + (type == KingCastle ? 5 : 3))));
+
+		position.pieces[Rook] ^= rookMask;
+		position.players[player] ^= rookMask;
+	}
+
+	mCurrent.activePlayer = opponent;
+}
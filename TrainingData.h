@@ -0,0 +1,105 @@
+#ifndef TRAININGDATA_H
+#define TRAININGDATA_H
+
+#include "Evaluator.h"
+#include "MappedFile.h"
+
+// Scored positions of self-play games, stored as chains : the first position of a game packed in 32 bytes, then
+// each move played with the score of the position it was played from, 4 bytes each, then 4 zero bytes.
+
+// Pieces in the order of the squares, 4 bits each : 0 to 5 for White pawn to king, 6 to 11 for Black
+struct PackedBoard
+{
+	u64 occupancy;
+	std::array<u8, 16> pieces;
+	u8 playerAndEnPassant; // Black to move in the high bit, the en passant square or 64 below
+	u8 halfmoveClock;
+	u16 ply;               // Plies played before the first position of the chain
+	u8 castlingRights;
+	u8 result;             // 0 : Black won, 1 : draw, 2 : White won
+	u16 reserved;
+};
+
+static_assert(sizeof(PackedBoard) == 32, "a packed board must fit in 32 bytes");
+
+struct ChainMove
+{
+	u16 move;   // Move code : type << 12 | from << 6 | to
+	i16 score;  // Centipawns, for the side to move
+};
+
+struct TrainingPosition
+{
+	PackedPosition position;
+	Player activePlayer;
+	i16 score;
+	u8 result;
+};
+
+// Chain of the game being played, encoded once its result is known
+class GameChain
+{
+public:
+	void start(const Game&, u16);
+	void add(const Move&, double);
+	void finish(u8, std::vector<u8>&);
+
+	size_t size() const;
+
+private:
+	PackedBoard mBoard;
+	std::vector<ChainMove> mMoves;
+};
+
+// Chains of several threads appended to one file : written by large blocks
+class TrainingWriter
+{
+public:
+	TrainingWriter();
+	~TrainingWriter();
+
+	bool open(const std::string&);
+	void close();
+
+	void write(const std::vector<u8>&);
+
+	u64 size() const;
+
+private:
+	static const size_t sBlockSize;
+
+	void _flush();
+
+	std::ofstream mFile;
+	std::vector<u8> mBuffer;
+	u64 mSize;
+
+	std::mutex mMutex;
+};
+
+// Replays the chains on bitboards, without move generation : the castling rights and the en passant square are only
+// known for the first position of each chain
+class TrainingReader
+{
+public:
+	TrainingReader();
+
+	bool open(const std::string&);
+	size_t read(std::vector<TrainingPosition>&, size_t);
+
+	bool isValid() const;
+
+private:
+	bool _readBoard();
+	void _play(u16);
+
+	MappedFile mFile;
+	size_t mOffset;
+	bool mIsValid;
+
+	// Position before the next move of the current chain
+	TrainingPosition mCurrent;
+	bool mIsInChain;
+};
+
+#endif // TRAININGDATA_H
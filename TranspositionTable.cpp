@@ -1,16 +1,16 @@
 #include "TranspositionTable.h"
 
 TranspositionTable::TranspositionTable(size_t size) :
-	mTable(size),
 	mEntries(0)
 {
+	TRACK_ALLOCATIONS(TranspositionTable);
+
+	mTable.resize(size);
 }
 
 TranspositionTable::~TranspositionTable()
 {
-	for (Entry* r : mTable)
-		if (r != nullptr)
-			delete r;
+	clear();
 }
 
 size_t TranspositionTable::entries() const
@@ -30,8 +30,30 @@ void TranspositionTable::tick()
 			r->isAncient = true;
 }
 
+void TranspositionTable::clear()
+{
+	for (Entry*& r : mTable) {
+		if (r != nullptr)
+			delete r;
+
+		r = nullptr;
+	}
+
+	mEntries = 0;
+}
+
+void TranspositionTable::resize(size_t size)
+{
+	TRACK_ALLOCATIONS(TranspositionTable);
+
+	clear();
+	mTable = std::vector<Entry*>(std::max<size_t>(size, 1));
+}
+
 void TranspositionTable::addEntry(const Entry& r)
 {
+	TRACK_ALLOCATIONS(TranspositionTable);
+
 	u32 i(r.hash % mTable.size());
 
 	if (mTable[i] == nullptr) {
@@ -48,8 +70,10 @@ const Entry& TranspositionTable::getEnty(u64 hash, bool& isEmpty) const
 	u32 i(hash % mTable.size());
 	isEmpty = mTable[i] == nullptr;
 
-	if (isEmpty)
-		return Entry();
+	if (isEmpty) {
+		static const Entry empty;
+		return empty;
+	}
 
 	mTable[i]->isAncient = false;
 
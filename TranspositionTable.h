@@ -2,6 +2,7 @@
 #define TRANSPOSITIONTABLE_H
 
 #include "Move.h"
+#include "MemoryTracker.h"
 
 struct Entry
 {
@@ -31,6 +32,8 @@ public:
 	size_t size() const;
 
 	void tick();
+	void clear();
+	void resize(size_t);
 
 	void addEntry(const Entry&);
 	const Entry& getEnty(u64, bool&) const;
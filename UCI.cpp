@@ -0,0 +1,517 @@
+#include "UCI.h"
+
+const std::string UCI::sStartPosition = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+const u16 UCI::sDefaultHashSize = 64;
+const u16 UCI::sMateHashSize = 16;
+const u8 UCI::sDefaultBenchDepth = 5;
+
+const std::array<std::string, 8> UCI::sBenchPositions = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+	"4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+	"rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+	"r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+	"r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+	"6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1"
+};
+
+UCI::UCI() :
+	mAI(_entries(sDefaultHashSize)),
+	mMateSolver((size_t(sMateHashSize) << 20) / sizeof(ProofEntry)),
+	mGame(new Game()),
+	mSearchDone(true)
+{
+	mAI.setVerbose(false);
+	mAI.setInfoCallback([this](const IterationStats& info) { _sendInfo(info); });
+}
+
+UCI::~UCI()
+{
+	_stop();
+
+#ifdef CHESS_TRACE_SEARCH
+	SearchTrace::close();
+#endif
+}
+
+void UCI::loop(std::istream& input)
+{
+	std::string line, command;
+
+	while (std::getline(input, line)) {
+		std::istringstream stream(line);
+
+		command.clear();
+		stream >> command;
+
+		if (command == "uci")
+			_uci();
+		else if (command == "isready")
+			_send("readyok");
+		else if (command == "ucinewgame") {
+			_stop();
+			mAI.clear();
+		} else if (command == "setoption")
+			_setOption(stream);
+		else if (command == "position")
+			_position(stream);
+		else if (command == "go")
+			_go(stream);
+		else if (command == "stop")
+			_stop();
+		else if (command == "ponderhit")
+			mAI.ponderhit();
+		else if (command == "perft")
+			_perft(stream);
+		else if (command == "evalbench")
+			_evalBench(stream);
+		else if (command == "bench") {
+			int depth(sDefaultBenchDepth);
+			stream >> depth;
+			bench(std::min(std::max(depth, 1), 255));
+		} else if (command == "quit")
+			break;
+		else if (!command.empty())
+			_send("info string unknown command " + command);
+	}
+
+	_stop();
+}
+
+// Fixed depth searches of a fixed set of positions, each from an empty transposition table.
+// The total number of nodes is a signature of the search : it only changes with its behavior.
+u64 UCI::bench(u8 depth)
+{
+	_stop();
+
+	SearchLimits limits;
+	limits.depth = depth;
+
+	u64 nodes(0);
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	for (const std::string& fen : sBenchPositions) {
+		Game game(fen);
+
+		SearchStats stats;
+
+		mAI.clear();
+		mAI.bestMove(game, limits, stats);
+
+		nodes += stats.nodes;
+		_logStats(stats);
+	}
+
+	u64 time(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count());
+
+	mAI.clear();
+
+	_send("Total time (ms) : " + std::to_string(time));
+	_send("Nodes searched  : " + std::to_string(nodes));
+	_send("Nodes/second    : " + std::to_string(1000 * nodes / std::max<u64>(time, 1)));
+
+	return nodes;
+}
+
+void UCI::_uci()
+{
+	_send("id name Chess");
+	_send("id author Marcus Nicolas");
+
+	_send("option name Hash type spin default " + std::to_string(sDefaultHashSize) + " min 1 max 4096");
+	_send("option name Threads type spin default 1 min 1 max 1");
+	_send("option name Ponder type check default true");
+	_send("option name MultiPV type spin default 1 min 1 max 64");
+	_send("option name StatsFile type string default <empty>");
+	_send("option name BookFile type string default <empty>");
+	_send("option name PositionFile type string default <empty>");
+#ifdef CHESS_SEARCH_TABLEBASES
+	_send("option name SyzygyPath type string default <empty>");
+#endif
+	_send("option name EvalFile type string default <empty>");
+#ifdef CHESS_TRACE_SEARCH
+	_send("option name TraceFile type string default <empty>");
+#endif
+
+	_send("uciok");
+}
+
+// setoption name <name> [value <value>]
+void UCI::_setOption(std::istringstream& stream)
+{
+	std::string token, name, value;
+
+	stream >> token;
+
+	while (stream >> token && token != "value")
+		name += (name.empty() ? "" : " ") + token;
+
+	// The rest of the line, for the paths with spaces
+	std::getline(stream >> std::ws, value);
+
+	if (name == "Hash" && !value.empty()) {
+		_wait();
+		mAI.resizeTranspositionTable(_entries(std::min(std::max(std::stoi(value), 1), 4096)));
+	} else if (name == "Threads") {
+		// The search is single threaded
+		if (!value.empty() && std::stoi(value) != 1)
+			_send("info string only 1 thread is supported");
+	} else if (name == "MultiPV" && !value.empty()) {
+		// The best move is still the one of the first line
+		_wait();
+		mAI.setMultiPV(u8(std::min(std::max(std::stoi(value), 1), 64)));
+	} else if (name == "StatsFile") {
+		// The stats of each search are appended to this file as a JSON line
+		_wait();
+		mStatsFile = value == "<empty>" ? "" : value;
+	} else if (name == "BookFile") {
+		_wait();
+		mAI.closeBook();
+
+		if (value != "<empty>" && !value.empty() && !mAI.openBook(value))
+			_send("info string cannot open the book " + value);
+	} else if (name == "PositionFile") {
+		// Probed after the book
+		_wait();
+		mAI.closeDatabase();
+
+		if (value != "<empty>" && !value.empty() && !mAI.openDatabase(value))
+			_send("info string cannot open the position database " + value);
+	} else if (name == "EvalFile") {
+		// Without a network, the search uses the material and piece-square tables evaluation
+		_wait();
+
+		if (value == "<empty>")
+			NNUE::instance().unload();
+		else if (!NNUE::instance().load(value))
+			_send("info string cannot load the network " + value);
+	}
+#ifdef CHESS_SEARCH_TABLEBASES
+	else if (name == "SyzygyPath") {
+		_wait();
+
+		if (!mAI.setTablebasesPath(value == "<empty>" ? "" : value) && value != "<empty>")
+			_send("info string no tablebase found in " + value);
+	}
+#endif
+#ifdef CHESS_TRACE_SEARCH
+	else if (name == "TraceFile") {
+		// The nodes of the following searches are recorded in this file, read by the trace tool
+		_wait();
+
+		if (value == "<empty>")
+			SearchTrace::close();
+		else if (!SearchTrace::open(value))
+			_send("info string cannot open " + value);
+	}
+#endif
+	else if (name != "Ponder")
+		_send("info string unknown option " + name);
+}
+
+// position [startpos | fen <fen>] [moves <move>...]
+void UCI::_position(std::istringstream& stream)
+{
+	std::string token, fen;
+
+	stream >> token;
+
+	if (token == "startpos") {
+		fen = sStartPosition;
+		stream >> token;
+	} else if (token == "fen") {
+		while (stream >> token && token != "moves")
+			fen += token + " ";
+	} else
+		return;
+
+	_wait();
+
+	try {
+		mGame.reset(new Game(fen));
+	} catch (const std::exception& e) {
+		_send(std::string("info string ") + e.what());
+		return;
+	}
+
+	while (stream >> token) {
+		const std::list<Move>& moves(mGame->possibleMoves());
+		std::list<Move>::const_iterator it = std::find_if(moves.begin(), moves.end(), [&token](const Move& m) { return m.toString() == token; });
+
+		if (it == moves.end()) {
+			_send("info string illegal move " + token);
+			break;
+		}
+
+		mGame->makeMove(*it);
+	}
+}
+
+// go [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [movetime <ms>] [depth <n>] [nodes <n>] [infinite] [ponder]
+void UCI::_go(std::istringstream& stream)
+{
+	SearchLimits limits;
+	std::string token;
+	int mate(0);
+
+	Player player(mGame->activePlayer());
+
+	while (stream >> token) {
+		if (token == "wtime" || token == "btime") {
+			u64 time(0);
+			stream >> time;
+
+			if ((token == "wtime") == (player == White))
+				limits.time = time;
+		} else if (token == "winc" || token == "binc") {
+			u64 increment(0);
+			stream >> increment;
+
+			if ((token == "winc") == (player == White))
+				limits.increment = increment;
+		} else if (token == "movestogo")
+			stream >> limits.movesToGo;
+		else if (token == "movetime")
+			stream >> limits.moveTime;
+		else if (token == "depth") {
+			int depth(0);
+			stream >> depth;
+			limits.depth = std::min(std::max(depth, 1), 255);
+		} else if (token == "nodes")
+			stream >> limits.nodes;
+		else if (token == "mate")
+			stream >> mate;
+		else if (token == "infinite")
+			limits.infinite = true;
+		else if (token == "ponder")
+			limits.ponder = true;
+	}
+
+	_wait();
+
+	if (mGame->possibleMoves().empty()) {
+		_send("bestmove 0000");
+		return;
+	}
+
+	mSearchDone = false;
+
+	// go mate <moves> : proof-number search of a mate for the side to move, until the proof, the node limit or the stop
+	if (mate > 0) {
+		mSearchThread = std::thread([this, mate, limits](Game root) {
+			mMateSolver.clear();
+			MateResult result(mMateSolver.solve(root, root.activePlayer(), u8(std::min(mate, 127)), limits.nodes));
+
+			if (result.isMate) {
+				std::ostringstream output;
+				output << "info depth " << result.line.size() << " score mate " << int(result.moves) << " nodes " << result.nodes
+				       << " nps " << 1000 * result.nodes / std::max<u64>(result.time, 1) << " time " << result.time << " pv";
+
+				for (const Move& move : result.line)
+					output << " " << move.toString();
+
+				_send(output.str());
+			} else
+				_send("info string no mate in " + std::to_string(mate) + " found");
+
+			std::string output("bestmove " + (result.bestMove == Move() ? root.possibleMoves().front() : result.bestMove).toString());
+
+			if (result.line.size() >= 2)
+				output += " ponder " + result.line[1].toString();
+
+			_send(output);
+			mSearchDone = true;
+		}, *mGame);
+
+		// The stop must not be handled before the solver starts
+		while (!mMateSolver.isSearching() && !mSearchDone)
+			std::this_thread::yield();
+
+		return;
+	}
+
+	mSearchThread = std::thread([this, limits](Game root) {
+		SearchStats stats;
+
+		Move move(mAI.bestMove(root, limits, stats));
+		std::string output("bestmove " + move.toString());
+
+		if (mAI.principalVariation().size() >= 2)
+			output += " ponder " + std::next(mAI.principalVariation().begin())->toString();
+
+		_send(output);
+		_logStats(stats);
+
+		mSearchDone = true;
+	}, *mGame);
+
+	// The limits must be set before a stop or a ponderhit can be handled
+	while (!mAI.isSearching() && !mSearchDone)
+		std::this_thread::yield();
+}
+
+// perft <depth> : counts the leaves of the current position and checks the incremental hashing and accumulators on the way
+void UCI::_perft(std::istringstream& stream)
+{
+	int depth(1);
+	stream >> depth;
+	depth = std::max(depth, 1);
+
+	_wait();
+
+	u64 nodes(0);
+	Game game(*mGame);
+
+	game.refreshAccumulator();
+
+	PROFILE_RESET();
+	perft(&game, nodes, depth);
+	PROFILE_REPORT(std::cerr);
+
+	_send("Nodes : " + std::to_string(nodes));
+	_send(std::string("Hashing : ") + (checkHashes(&game, depth) ? "ok" : "incremental hash differs from its full computation"));
+
+	if (NNUE::instance().isLoaded())
+		_send(std::string("Accumulators : ") + (checkAccumulators(&game, depth) ? "ok" : "incremental accumulator differs from its full computation"));
+}
+
+// evalbench [depth] : evaluations per second on the trees of the bench positions. The batch evaluation of the tables
+// is compared with their scalar evaluation, and the incremental accumulators of the network, if loaded, with their
+// full computation.
+void UCI::_evalBench(std::istringstream& stream)
+{
+	int depth(2);
+	stream >> depth;
+	depth = std::min(std::max(depth, 1), 3);
+
+	_wait();
+
+	bool hasNetwork(NNUE::instance().isLoaded());
+	std::vector<PackedPosition> positions;
+	std::vector<std::pair<Accumulator, Player>> accumulators;
+	bool isValid(true);
+
+	for (const std::string& fen : sBenchPositions) {
+		Game game(fen);
+
+		if (hasNetwork)
+			isValid = isValid && checkAccumulators(&game, depth);
+
+		_collectPositions(&game, depth, positions, hasNetwork ? &accumulators : nullptr);
+	}
+
+	// Each evaluation is repeated up to 10 million evaluations
+	const Evaluator& evaluator(mAI.evaluator());
+	size_t repetitions(std::max<size_t>(10000000 / positions.size(), 1));
+	u64 evaluations(repetitions * positions.size());
+
+	std::vector<double> scalarScores(positions.size()), batchScores(positions.size());
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	for (size_t i(0); i < repetitions; ++i)
+		for (size_t j(0); j < positions.size(); ++j)
+			scalarScores[j] = evaluator.evaluate(positions[j]);
+
+	u64 scalarTime(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count());
+	begin = std::chrono::steady_clock::now();
+
+	for (size_t i(0); i < repetitions; ++i)
+		evaluator.evaluate(positions.data(), positions.size(), batchScores.data());
+
+	u64 batchTime(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count());
+
+	_send("Positions                     : " + std::to_string(positions.size()));
+	_send("Tables, scalar (positions/s)  : " + std::to_string(1000000 * evaluations / std::max<u64>(scalarTime, 1)));
+	_send("Tables, batch (positions/s)   : " + std::to_string(1000000 * evaluations / std::max<u64>(batchTime, 1)));
+	_send(std::string("Tables, batch scores          : ") + (scalarScores == batchScores ? "identical" : "differ from the scalar scores"));
+
+	if (!hasNetwork)
+		return;
+
+	// The sum keeps the evaluations from being optimized away
+	i64 sum(0);
+	begin = std::chrono::steady_clock::now();
+
+	for (size_t i(0); i < repetitions; ++i)
+		for (const std::pair<Accumulator, Player>& accumulator : accumulators)
+			sum += NNUE::instance().evaluate(accumulator.first, accumulator.second);
+
+	u64 time(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count());
+
+	_send("Network (evaluations/s)       : " + std::to_string(1000000 * evaluations / std::max<u64>(time, 1)) + " (checksum " + std::to_string(sum) + ")");
+	_send(std::string("Network, accumulators         : ") + (isValid ? "ok" : "incremental accumulator differs from its full computation"));
+}
+
+void UCI::_collectPositions(Game* game, int depth, std::vector<PackedPosition>& positions, std::vector<std::pair<Accumulator, Player>>* accumulators)
+{
+	positions.push_back(PackedPosition::pack(*game));
+
+	if (accumulators)
+		accumulators->push_back({ game->accumulator(), game->activePlayer() });
+
+	if (!depth)
+		return;
+
+	std::list<Move> moves(game->possibleMoves());
+
+	for (Move move : moves) {
+		game->makeMove(move);
+		_collectPositions(game, depth - 1, positions, accumulators);
+		game->unmakeMove();
+	}
+}
+
+void UCI::_stop()
+{
+	mAI.stop();
+	mMateSolver.stop();
+	_wait();
+}
+
+void UCI::_wait()
+{
+	if (mSearchThread.joinable())
+		mSearchThread.join();
+}
+
+void UCI::_send(const std::string& message)
+{
+	std::lock_guard<std::mutex> lock(mOutputMutex);
+	std::cout << message << std::endl;
+}
+
+void UCI::_sendInfo(const IterationStats& info)
+{
+	std::ostringstream output;
+
+	output << "info depth " << int(info.depth) << " multipv " << int(info.line) << " score ";
+
+	// The evaluation of a mated position is 1000
+	if (std::abs(info.score) >= 999)
+		output << "mate " << (info.score > 0 ? 1 : -1) * int(info.principalVariation.size() + 1) / 2;
+	else
+		output << "cp " << i64(std::round(100 * info.score));
+
+	output << " nodes " << info.nodes << " nps " << 1000 * info.nodes / std::max<u64>(info.time, 1) << " time " << info.time << " pv";
+
+	for (const Move& move : info.principalVariation)
+		output << " " << move.toString();
+
+	_send(output.str());
+}
+
+void UCI::_logStats(const SearchStats& stats)
+{
+	if (mStatsFile.empty())
+		return;
+
+	std::ofstream file(mStatsFile, std::ios::app);
+	file << stats.toJson() << "\n";
+}
+
+// Number of transposition table entries for a size in MB
+size_t UCI::_entries(u16 size)
+{
+	return (size_t(size) << 20) / (sizeof(Entry*) + sizeof(Entry));
+}
@@ -0,0 +1,54 @@
+#ifndef UCI_H
+#define UCI_H
+
+#include "AI.h"
+#include "MateSolver.h"
+
+// Universal Chess Interface : the commands are read on the calling thread, the search runs on its own thread
+class UCI
+{
+public:
+	UCI();
+	~UCI();
+
+	void loop(std::istream&);
+	u64 bench(u8);
+
+	static const u8 sDefaultBenchDepth;
+
+private:
+	static const std::string sStartPosition;
+	static const std::array<std::string, 8> sBenchPositions;
+	static const u16 sDefaultHashSize;
+	static const u16 sMateHashSize;
+
+	void _uci();
+	void _setOption(std::istringstream&);
+	void _position(std::istringstream&);
+	void _go(std::istringstream&);
+	void _perft(std::istringstream&);
+	void _evalBench(std::istringstream&);
+
+	void _stop();
+	void _wait();
+
+	void _send(const std::string&);
+	void _sendInfo(const IterationStats&);
+	void _logStats(const SearchStats&);
+
+	static size_t _entries(u16);
+	static void _collectPositions(Game*, int, std::vector<PackedPosition>&, std::vector<std::pair<Accumulator, Player>>*);
+
+	AI mAI;
+	MateSolver mMateSolver;
+	std::unique_ptr<Game> mGame;
+
+	std::string mStatsFile;
+
+	std::thread mSearchThread;
+	std::atomic<bool> mSearchDone;
+
+	std::mutex mOutputMutex;
+};
+
+#endif // UCI_H
@@ -0,0 +1,270 @@
+#include "AI.h"
+
+// Headless analysis of a stream of positions, by a pool of workers each with its own search and transposition table.
+// Built like the UCI engine, with this file as main.
+//
+// analyze [<epd> | -] [--threads <n>] [--depth <n> | --nodes <n> | --movetime <ms>] [--hash <MB>] [--queue <n>]
+//
+// The positions are read from the file, or from stdin with "-" or without a file, as soon as the workers can take
+// them : at most --queue positions are read ahead of the last result written. Each result is a JSON line on stdout,
+// in the order of the input :
+//   {"index":0,"id":"...","fen":"...","bestmove":"e2e4","score":{"cp":35},"depth":8,"nodes":91234,"time":412,"pv":"e2e4 e7e5"}
+// The score is for the side to move, "mate" replacing "cp" for mates. An unreadable line gives {"index":n,"error":"..."}.
+
+struct Job
+{
+	u64 index;
+	std::string line;
+};
+
+// Lines read ahead of the output : the reader waits while the window is full, so that neither the jobs nor the
+// results waiting for an earlier one can grow without bound
+class Pipeline
+{
+public:
+	Pipeline(size_t capacity) :
+		mCapacity(capacity),
+		mNextIndex(0),
+		mNextOutput(0),
+		mIsClosed(false)
+	{
+	}
+
+	void push(const std::string& line)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mWindowCondition.wait(lock, [this]() { return mNextIndex - mNextOutput < mCapacity; });
+
+		mJobs.push_back({ mNextIndex++, line });
+		mJobsCondition.notify_one();
+	}
+
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsClosed = true;
+		mJobsCondition.notify_all();
+	}
+
+	// False once the input is closed and every job taken
+	bool pop(Job& job)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mJobsCondition.wait(lock, [this]() { return !mJobs.empty() || mIsClosed; });
+
+		if (mJobs.empty())
+			return false;
+
+		job = std::move(mJobs.front());
+		mJobs.pop_front();
+
+		return true;
+	}
+
+	// Writes the result and the following ones already done
+	void done(u64 index, const std::string& result)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mResults[index] = result;
+
+		for (std::map<u64, std::string>::iterator it(mResults.begin()); it != mResults.end() && it->first == mNextOutput; it = mResults.erase(it)) {
+			std::cout << it->second << "\n";
+			++mNextOutput;
+		}
+
+		mWindowCondition.notify_one();
+	}
+
+	u64 written() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mNextOutput;
+	}
+
+private:
+	size_t mCapacity;
+	u64 mNextIndex;
+	u64 mNextOutput;
+	bool mIsClosed;
+
+	std::deque<Job> mJobs;
+	std::map<u64, std::string> mResults;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mJobsCondition;
+	std::condition_variable mWindowCondition;
+};
+
+static std::string escape(const std::string& text)
+{
+	std::string escaped;
+
+	for (char c : text) {
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+
+		if (c >= ' ')
+			escaped += c;
+	}
+
+	return escaped;
+}
+
+// EPD : the 4 fields of the position, then operations such as id "name"; whose id is kept
+static std::string analyze(AI& ai, const SearchLimits& limits, const Job& job)
+{
+	std::ostringstream json;
+	std::istringstream stream(job.line);
+	std::string placement, activePlayer, castlingRights, enPassant, id;
+
+	json << "{\"index\":" << job.index;
+
+	size_t idPosition(job.line.find("id \""));
+
+	if (idPosition != std::string::npos) {
+		size_t end(job.line.find('"', idPosition + 4));
+		id = job.line.substr(idPosition + 4, end == std::string::npos ? std::string::npos : end - idPosition - 4);
+		json << ",\"id\":\"" << escape(id) << "\"";
+	}
+
+	if (!(stream >> placement >> activePlayer >> castlingRights >> enPassant))
+		return json.str() + ",\"error\":\"incomplete position\"}";
+
+	std::string fen(placement + " " + activePlayer + " " + castlingRights + " " + enPassant);
+	json << ",\"fen\":\"" << escape(fen) << "\"";
+
+	try {
+		Game game(fen);
+
+		if (game.isOver())
+			return json.str() + ",\"error\":\"no legal move\"}";
+
+		SearchStats stats;
+
+		ai.clear();
+		Move move(ai.bestMove(game, limits, stats));
+
+		json << ",\"bestmove\":\"" << move.toString() << "\"";
+
+		if (stats.iterations.empty()) {
+			json << ",\"score\":null,\"depth\":0,\"nodes\":" << stats.nodes << ",\"time\":" << stats.time << ",\"pv\":\"" << move.toString() << "\"}";
+			return json.str();
+		}
+
+		const IterationStats& iteration(stats.iterations.back());
+
+		// The evaluation of a mated position is 1000, as in the UCI output
+		if (std::abs(iteration.score) >= 999)
+			json << ",\"score\":{\"mate\":" << (iteration.score > 0 ? 1 : -1) * int(iteration.principalVariation.size() + 1) / 2 << "}";
+		else
+			json << ",\"score\":{\"cp\":" << i64(std::round(100 * iteration.score)) << "}";
+
+		json << ",\"depth\":" << int(iteration.depth) << ",\"nodes\":" << stats.nodes << ",\"time\":" << stats.time << ",\"pv\":\"";
+
+		for (std::list<Move>::const_iterator it(iteration.principalVariation.begin()); it != iteration.principalVariation.end(); ++it)
+			json << (it == iteration.principalVariation.begin() ? "" : " ") << it->toString();
+
+		json << "\"}";
+	} catch (const std::runtime_error& error) {
+		return json.str() + ",\"error\":\"" + escape(error.what()) + "\"}";
+	}
+
+	return json.str();
+}
+
+int main(int argc, char* argv[])
+{
+	// Before any input or output : the output is flushed by blocks, not at each line
+	std::ios::sync_with_stdio(false);
+
+	std::string path("-");
+	unsigned threadsCount(std::max(std::thread::hardware_concurrency(), 1u));
+	u16 hash(16);
+	size_t capacity(1024);
+
+	SearchLimits limits;
+	limits.depth = 8;
+
+	int i(1);
+
+	if (argc > 1 && std::string(argv[1]).compare(0, 2, "--"))
+		path = argv[i++];
+
+	for (; i + 1 < argc; i += 2) {
+		std::string option(argv[i]);
+		u64 value(std::strtoull(argv[i + 1], nullptr, 10));
+
+		if (option == "--threads")
+			threadsCount = unsigned(std::max<u64>(value, 1));
+		else if (option == "--depth") {
+			limits.depth = u8(std::min<u64>(std::max<u64>(value, 1), 255));
+			limits.nodes = 0;
+			limits.moveTime = 0;
+		} else if (option == "--nodes") {
+			limits.nodes = std::max<u64>(value, 1);
+			limits.depth = 0;
+			limits.moveTime = 0;
+		} else if (option == "--movetime") {
+			limits.moveTime = std::max<u64>(value, 1);
+			limits.depth = 0;
+			limits.nodes = 0;
+		} else if (option == "--hash")
+			hash = u16(std::min<u64>(std::max<u64>(value, 1), 4096));
+		else if (option == "--queue")
+			capacity = std::max<u64>(value, 1);
+		else {
+			std::cerr << "Usage : analyze [<epd> | -] [--threads <n>] [--depth <n> | --nodes <n> | --movetime <ms>] [--hash <MB>] [--queue <n>]\n";
+			return 1;
+		}
+	}
+
+	std::ifstream file;
+
+	if (path != "-") {
+		file.open(path);
+
+		if (!file) {
+			std::cerr << "Cannot open " << path << "\n";
+			return 1;
+		}
+	}
+
+	std::istream& input(path == "-" ? std::cin : file);
+
+	Pipeline pipeline(capacity);
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+
+	for (unsigned i(0); i < threadsCount; ++i) {
+		threads.emplace_back([&]() {
+			AI ai((size_t(hash) << 20) / (sizeof(Entry*) + sizeof(Entry)));
+			Job job;
+
+			ai.setVerbose(false);
+
+			while (pipeline.pop(job))
+				pipeline.done(job.index, analyze(ai, limits, job));
+		});
+	}
+
+	std::string line;
+
+	while (std::getline(input, line)) {
+		if (line.find_first_not_of(" \t\r") != std::string::npos)
+			pipeline.push(line);
+	}
+
+	pipeline.close();
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	std::cout.flush();
+
+	double seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+	u64 count(pipeline.written());
+
+	std::cerr << "Positions : " << count << " in " << seconds << " s with " << threadsCount << " workers : " << count / seconds << " positions/s\n";
+
+	return 0;
+}
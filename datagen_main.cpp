@@ -0,0 +1,212 @@
+#include "TrainingData.h"
+#include "AI.h"
+#include "Adjudicator.h"
+
+// Self-play generation of scored positions, one game per thread, in the chain format of TrainingData.h.
+// Built like the UCI engine, with this file as main.
+//
+// datagen <file> [--games <n>] [--threads <n>] [--depth <n> | --nodes <n>] [--random-plies <n>] [--seed <n>]
+// datagen --read <file>                      : decodes the whole file and reports the decoding speed
+//
+// Each game starts with random moves, which are not recorded, then the engine plays both sides at a fixed depth
+// (5 by default) or node count. The score of each recorded position is the score of its search.
+
+// Scores in pawns, for the side which just searched, and counts in plies
+static const double sResignScore = 10;
+static const u16 sResignPlies = 8;
+static const u16 sMaxPlies = 400;
+
+// Chains are handed to the writer by blocks of this size
+static const size_t sThreadBuffer = 1 << 20;
+
+// Result for White : 0, 1 or 2
+static u8 playGame(AI& ai, const SearchLimits& limits, u16 randomPlies, std::mt19937& random, GameChain& chain)
+{
+	Game game;
+
+	for (u16 i(0); i < randomPlies && !game.isOver(); ++i) {
+		const std::list<Move>& moves(game.possibleMoves());
+		game.makeMove(*std::next(moves.begin(), random() % moves.size()));
+	}
+
+	chain.start(game, randomPlies);
+
+	if (game.isOver())
+		return 1;
+
+	ai.clear();
+
+	// No draw adjudication
+	Adjudicator adjudicator(sResignScore, sResignPlies, 0, 0, 0, sMaxPlies);
+	Status status(Ongoing);
+
+	for (u16 ply(randomPlies); status == Ongoing && !game.isOver(); ++ply) {
+		if (adjudicator.isDrawn(game, ply))
+			return 1;
+
+		SearchStats stats;
+		Move move(ai.bestMove(game, limits, stats));
+		double score(stats.iterations.empty() ? 0 : stats.iterations.back().score);
+
+		chain.add(move, score);
+		game.makeMove(move);
+
+		status = adjudicator.update(ply, playerSign(otherPlayer(game.activePlayer())) * score);
+	}
+
+	if (status == Ongoing)
+		status = game.status();
+
+	switch (status) {
+	case WhiteWin:
+		return 2;
+
+	case BlackWin:
+		return 0;
+
+	default:
+		return 1;
+	}
+}
+
+static int generate(const std::string& path, u64 gamesCount, unsigned threadsCount, const SearchLimits& limits, u16 randomPlies, u64 seed)
+{
+	TrainingWriter writer;
+
+	if (!writer.open(path)) {
+		std::cerr << "Cannot open " << path << "\n";
+		return 1;
+	}
+
+	std::atomic<u64> nextGame(0), positions(0);
+	std::mutex outputMutex;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+
+	for (unsigned i(0); i < threadsCount; ++i) {
+		threads.emplace_back([&]() {
+			AI ai((size_t(16) << 20) / (sizeof(Entry*) + sizeof(Entry)));
+			GameChain chain;
+			std::vector<u8> buffer;
+
+			ai.setVerbose(false);
+
+			for (u64 index(nextGame++); index < gamesCount; index = nextGame++) {
+				// The random moves of a game only depend on the seed and on its index
+				std::mt19937 random(u32(seed + index));
+
+				chain.finish(playGame(ai, limits, randomPlies, random, chain), buffer);
+				positions += chain.size();
+
+				if (buffer.size() >= sThreadBuffer) {
+					writer.write(buffer);
+					buffer.clear();
+				}
+
+				if ((index + 1) % 100 == 0) {
+					double seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+
+					std::lock_guard<std::mutex> lock(outputMutex);
+					std::cerr << "Games " << index + 1 << "  positions " << positions << "  " << u64(positions / seconds) << " positions/s\n";
+				}
+			}
+
+			writer.write(buffer);
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	writer.close();
+
+	std::cout << "Games : " << gamesCount << ", positions : " << positions << ", " << writer.size() << " bytes ("
+	          << double(writer.size()) / std::max<u64>(positions, 1) << " bytes/position)\n";
+
+	return 0;
+}
+
+static int read(const std::string& path)
+{
+	TrainingReader reader;
+
+	if (!reader.open(path)) {
+		std::cerr << "Cannot open " << path << "\n";
+		return 1;
+	}
+
+	std::vector<TrainingPosition> positions;
+	std::array<u64, 3> results = { 0, 0, 0 };
+	u64 count(0);
+	i64 scores(0);
+
+	positions.reserve(1 << 16);
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	for (positions.clear(); reader.read(positions, 1 << 16); positions.clear()) {
+		for (const TrainingPosition& position : positions) {
+			scores += position.score;
+			++results[std::min<u8>(position.result, 2)];
+		}
+
+		count += positions.size();
+	}
+
+	double seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+	u64 size(std::filesystem::file_size(path));
+
+	if (!reader.isValid())
+		std::cerr << "Corrupt data after " << count << " positions\n";
+
+	std::cout << "Positions : " << count << " (White wins " << results[2] << ", draws " << results[1] << ", Black wins " << results[0]
+	          << ", mean score " << double(scores) / std::max<u64>(count, 1) << " cp)\n";
+	std::cout << "Decoded " << size / 1048576. << " MB in " << seconds << " s : " << size / seconds / 1048576 << " MB/s, "
+	          << u64(count / seconds) << " positions/s\n";
+
+	return reader.isValid() ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cerr << "Usage : datagen <file> [--games <n>] [--threads <n>] [--depth <n> | --nodes <n>] [--random-plies <n>] [--seed <n>]\n";
+		std::cerr << "        datagen --read <file>\n";
+		return 1;
+	}
+
+	if (std::string(argv[1]) == "--read")
+		return argc > 2 ? read(argv[2]) : 1;
+
+	u64 gamesCount(1000), seed(0);
+	unsigned threadsCount(std::max(std::thread::hardware_concurrency(), 1u));
+	u16 randomPlies(8);
+
+	SearchLimits limits;
+	limits.depth = 5;
+
+	for (int i(2); i + 1 < argc; i += 2) {
+		std::string option(argv[i]);
+		u64 value(std::strtoull(argv[i + 1], nullptr, 10));
+
+		if (option == "--games")
+			gamesCount = value;
+		else if (option == "--threads")
+			threadsCount = unsigned(std::max<u64>(value, 1));
+		else if (option == "--depth") {
+			limits.depth = u8(std::min<u64>(std::max<u64>(value, 1), 255));
+			limits.nodes = 0;
+		} else if (option == "--nodes") {
+			limits.nodes = std::max<u64>(value, 1);
+			limits.depth = 0;
+		} else if (option == "--random-plies")
+			randomPlies = u16(value);
+		else if (option == "--seed")
+			seed = value;
+		else {
+			std::cerr << "Unknown option " << option << "\n";
+			return 1;
+		}
+	}
+
+	return generate(argv[1], gamesCount, threadsCount, limits, randomPlies, seed);
+}
@@ -2,7 +2,11 @@
 
 u8 popcount(u64 x)
 {
+#ifdef _MSC_VER
 	return __popcnt64(x);
+#else
+	return __builtin_popcountll(x);
+#endif
 }
 
 u64 circularShift(u64 x, u8 shift)
@@ -13,8 +17,12 @@ u64 circularShift(u64 x, u8 shift)
 
 u8 bsfReset(u64& x)
 {
+#ifdef _MSC_VER
 	u32 out(0);
 	_BitScanForward64(&out, x);
+#else
+	u32 out(x ? __builtin_ctzll(x) : 0);
+#endif
 
 	x &= x - 1;
 
@@ -1,7 +1,9 @@
 #ifndef DEFS_H
 #define DEFS_H
 
+#ifdef _MSC_VER
 #include <intrin.h>
+#endif
 
 #include <utility>
 #include <algorithm>
@@ -12,17 +14,30 @@
 #include <map>
 #include <exception>
 #include <stack>
+#include <deque>
 
 #include <chrono>
+#include <atomic>
+#include <thread>
+#include <future>
 
 #include <string>
+#include <string_view>
 #include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 #include <random>
-#include <chrono>
-
-#include <SFML\Graphics.hpp>
-#include <SFML\Audio.hpp>
+#include <cmath>
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <stdexcept>
+#include <sstream>
+#include <filesystem>
 
 typedef char i8;
 typedef short i16;
@@ -0,0 +1,342 @@
+#include "AI.h"
+#include "Adjudicator.h"
+
+// Headless match between two configurations of the engine, one game per thread, in-process.
+// Built like the UCI engine, with this file as main.
+//
+// match [--engine1 <config>] [--engine2 <config>] [--openings <epd>] [--games <n>] [--threads <n>]
+//       [--sprt <elo0>,<elo1>[,<alpha>,<beta>]] [--network <file>]
+//
+// A configuration is a list of key=value separated by commas, among
+//   hash=<MB>  nodes=<n>  depth=<n>  movetime=<ms>  tc=<seconds>+<increment seconds>  network=on|off
+// for instance "nodes=20000" or "tc=10+0.1,hash=32". Each opening is played twice, each engine having White once.
+// The results are from the point of view of the first engine.
+
+struct EngineConfig
+{
+	std::string description;
+	u16 hash;
+	SearchLimits limits;
+	u64 time;      // Clock of a game (ms), 0 without a time control
+	u64 increment; // ms
+	bool usesNetwork;
+};
+
+struct Sprt
+{
+	bool isEnabled;
+	double elo0;
+	double elo1;
+	double alpha;
+	double beta;
+};
+
+// Scores in pawns, for the side which just searched, and counts in plies
+static const double sResignScore = 6;
+static const u16 sResignPlies = 8;
+static const double sDrawScore = .05;
+static const u16 sDrawPlies = 16;
+static const u16 sDrawMinPlies = 80;
+static const u16 sMaxPlies = 500;
+
+// Games played before the SPRT can stop the match
+static const u64 sSprtMinGames = 32;
+
+struct Results
+{
+	u64 wins;
+	u64 losses;
+	u64 draws;
+	u64 timeLosses; // Games lost on time by either engine
+
+	u64 games() const { return wins + losses + draws; }
+};
+
+static EngineConfig parseConfig(const std::string& text)
+{
+	EngineConfig config({ text, 16, SearchLimits(), 0, 0, true });
+	std::istringstream stream(text);
+	std::string item;
+
+	while (std::getline(stream, item, ',')) {
+		size_t equal(item.find('='));
+		std::string key(item.substr(0, equal)), value(equal == std::string::npos ? "" : item.substr(equal + 1));
+
+		if (key == "hash")
+			config.hash = u16(std::min(std::max(std::atoi(value.c_str()), 1), 4096));
+		else if (key == "nodes")
+			config.limits.nodes = std::strtoull(value.c_str(), nullptr, 10);
+		else if (key == "depth")
+			config.limits.depth = u8(std::min(std::max(std::atoi(value.c_str()), 1), 255));
+		else if (key == "movetime")
+			config.limits.moveTime = std::strtoull(value.c_str(), nullptr, 10);
+		else if (key == "tc") {
+			size_t plus(value.find('+'));
+
+			config.time = u64(1000 * std::atof(value.substr(0, plus).c_str()));
+			config.increment = plus == std::string::npos ? 0 : u64(1000 * std::atof(value.substr(plus + 1).c_str()));
+		} else if (key == "network")
+			config.usesNetwork = value != "off";
+		else if (!key.empty())
+			throw std::runtime_error("unknown engine option " + key);
+	}
+
+	if (!config.time && !config.limits.nodes && !config.limits.depth && !config.limits.moveTime)
+		throw std::runtime_error("no limit for the engine " + text);
+
+	return config;
+}
+
+static std::vector<std::string> loadOpenings(const std::string& path)
+{
+	std::vector<std::string> openings;
+	std::ifstream file(path);
+	std::string line;
+
+	if (!file)
+		throw std::runtime_error("cannot open " + path);
+
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string placement, activePlayer, castlingRights, enPassant;
+
+		if (stream >> placement >> activePlayer >> castlingRights >> enPassant)
+			openings.push_back(placement + " " + activePlayer + " " + castlingRights + " " + enPassant);
+	}
+
+	return openings;
+}
+
+// Result for the first engine : 1, .5 or 0
+static double playGame(const std::string& fen, bool isFirstWhite, const std::array<EngineConfig, 2>& configs, std::array<std::unique_ptr<AI>, 2>& ais, bool& isTimeLoss)
+{
+	Game game(fen);
+	std::array<i64, 2> clocks = { i64(configs[0].time), i64(configs[1].time) };
+	Adjudicator adjudicator(sResignScore, sResignPlies, sDrawScore, sDrawPlies, sDrawMinPlies, sMaxPlies);
+	Status status(Ongoing);
+
+	isTimeLoss = false;
+
+	for (std::unique_ptr<AI>& ai : ais)
+		ai->clear();
+
+	for (u16 ply(0); status == Ongoing && !game.isOver(); ++ply) {
+		Player player(game.activePlayer());
+		size_t engine((player == White) == isFirstWhite ? 0 : 1);
+
+		if (adjudicator.isDrawn(game, ply))
+			return .5;
+
+		SearchLimits limits(configs[engine].limits);
+		SearchStats stats;
+
+		if (configs[engine].time) {
+			limits.time = u64(std::max<i64>(clocks[engine], 1));
+			limits.increment = configs[engine].increment;
+		}
+
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		Move move(ais[engine]->bestMove(game, limits, stats));
+
+		if (configs[engine].time) {
+			clocks[engine] -= std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+
+			if (clocks[engine] < 0) {
+				isTimeLoss = true;
+				return engine == 0 ? 0 : 1;
+			}
+
+			clocks[engine] += configs[engine].increment;
+		}
+
+		game.makeMove(move);
+
+		// Adjudication on the scores of both engines, from White's point of view
+		status = adjudicator.update(ply, stats.iterations.empty() ? 0 : playerSign(player) * stats.iterations.back().score);
+	}
+
+	if (status == Ongoing)
+		status = game.status();
+
+	switch (status) {
+	case WhiteWin:
+		return isFirstWhite ? 1 : 0;
+
+	case BlackWin:
+		return isFirstWhite ? 0 : 1;
+
+	default:
+		return .5;
+	}
+}
+
+static double eloFromScore(double score)
+{
+	return -400 * std::log10(1 / score - 1);
+}
+
+static double scoreFromElo(double elo)
+{
+	return 1 / (1 + std::pow(10, -elo / 400));
+}
+
+// Mean score of the games and its variance, per game
+static std::pair<double, double> scoreStatistics(double wins, double draws, double losses)
+{
+	double n(wins + draws + losses);
+	double score((wins + .5 * draws) / n);
+	double variance((wins * std::pow(1 - score, 2) + draws * std::pow(.5 - score, 2) + losses * std::pow(score, 2)) / n);
+
+	return { score, variance };
+}
+
+// Generalized SPRT : log-likelihood ratio of the trinomial results between the hypotheses elo1 and elo0, with the
+// score and its variance estimated from the games, normal approximation. 0 until sSprtMinGames games are played and
+// the results differ, as the variance is then not a usable estimate.
+static double logLikelihoodRatio(const Results& results, const Sprt& sprt)
+{
+	if (results.games() < sSprtMinGames)
+		return 0;
+
+	std::pair<double, double> statistics(scoreStatistics(double(results.wins), double(results.draws), double(results.losses)));
+	double s0(scoreFromElo(sprt.elo0)), s1(scoreFromElo(sprt.elo1));
+
+	if (statistics.second <= 0)
+		return 0;
+
+	return results.games() * (s1 - s0) * (2 * statistics.first - s0 - s1) / (2 * statistics.second);
+}
+
+static std::string formatResults(const Results& results, const Sprt& sprt)
+{
+	std::ostringstream text;
+	text.setf(std::ios::fixed);
+	text.precision(1);
+
+	text << "Games " << results.games() << " : +" << results.wins << " -" << results.losses << " =" << results.draws;
+
+	if (results.wins && results.losses) {
+		std::pair<double, double> statistics(scoreStatistics(double(results.wins), double(results.draws), double(results.losses)));
+		double margin(1.96 * std::sqrt(statistics.second / results.games()));
+
+		double elo(eloFromScore(statistics.first));
+		double low(eloFromScore(std::max(statistics.first - margin, 1e-6))), high(eloFromScore(std::min(statistics.first + margin, 1 - 1e-6)));
+
+		text << "  Elo " << elo << " +" << high - elo << " -" << elo - low;
+	}
+
+	if (sprt.isEnabled) {
+		text.precision(2);
+		text << "  LLR " << logLikelihoodRatio(results, sprt) << " [" << std::log(sprt.beta / (1 - sprt.alpha)) << ", " << std::log((1 - sprt.beta) / sprt.alpha) << "]";
+	}
+
+	return text.str();
+}
+
+int main(int argc, char* argv[])
+{
+	std::array<EngineConfig, 2> configs;
+	std::vector<std::string> openings = { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -" };
+	u64 gamesCount(1000);
+	unsigned threadsCount(std::max(std::thread::hardware_concurrency(), 1u));
+	Sprt sprt({ false, 0, 5, .05, .05 });
+
+	try {
+		configs = { parseConfig("nodes=20000"), parseConfig("nodes=20000") };
+
+		for (int i(1); i + 1 < argc; i += 2) {
+			std::string option(argv[i]), value(argv[i + 1]);
+
+			if (option == "--engine1" || option == "--engine2")
+				configs[option == "--engine2"] = parseConfig(value);
+			else if (option == "--openings")
+				openings = loadOpenings(value);
+			else if (option == "--games")
+				gamesCount = std::max<u64>(std::strtoull(value.c_str(), nullptr, 10), 1);
+			else if (option == "--threads")
+				threadsCount = std::max(std::atoi(value.c_str()), 1);
+			else if (option == "--sprt") {
+				sprt.isEnabled = true;
+				std::sscanf(value.c_str(), "%lf,%lf,%lf,%lf", &sprt.elo0, &sprt.elo1, &sprt.alpha, &sprt.beta);
+			} else if (option == "--network") {
+				if (!NNUE::instance().load(value))
+					throw std::runtime_error("cannot load the network " + value);
+			} else
+				throw std::runtime_error("unknown option " + option);
+		}
+	} catch (const std::runtime_error& error) {
+		std::cerr << error.what() << "\n";
+		return 1;
+	}
+
+	if (openings.empty()) {
+		std::cerr << "No opening\n";
+		return 1;
+	}
+
+	// Games are played by pairs on the same opening
+	gamesCount += gamesCount % 2;
+
+	std::cout << "Engine 1 : " << configs[0].description << "\nEngine 2 : " << configs[1].description << "\n";
+	std::cout << gamesCount << " games, " << openings.size() << " openings, " << threadsCount << " threads\n\n";
+
+	Results results({ 0, 0, 0, 0 });
+	std::mutex resultsMutex;
+	std::atomic<u64> nextGame(0);
+	std::atomic<bool> isDecided(false);
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+
+	for (unsigned i(0); i < threadsCount; ++i) {
+		threads.emplace_back([&]() {
+			std::array<std::unique_ptr<AI>, 2> ais;
+
+			for (size_t engine(0); engine < 2; ++engine) {
+				ais[engine].reset(new AI((size_t(configs[engine].hash) << 20) / (sizeof(Entry*) + sizeof(Entry))));
+				ais[engine]->setVerbose(false);
+				ais[engine]->setUsesNetwork(configs[engine].usesNetwork);
+			}
+
+			for (u64 index(nextGame++); index < gamesCount && !isDecided; index = nextGame++) {
+				bool isTimeLoss(false);
+				double result(playGame(openings[(index / 2) % openings.size()], index % 2 == 0, configs, ais, isTimeLoss));
+
+				std::lock_guard<std::mutex> lock(resultsMutex);
+
+				results.wins += result == 1;
+				results.losses += result == 0;
+				results.draws += result == .5;
+				results.timeLosses += isTimeLoss;
+
+				std::cout << formatResults(results, sprt) << "\n";
+
+				double llr(logLikelihoodRatio(results, sprt));
+
+				if (sprt.isEnabled && (llr <= std::log(sprt.beta / (1 - sprt.alpha)) || llr >= std::log((1 - sprt.beta) / sprt.alpha)))
+					isDecided = true;
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	double hours(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() / 3600);
+
+	std::cout << "\n" << formatResults(results, sprt) << "\n";
+	std::cout << "Games/hour : " << u64(results.games() / std::max(hours, 1e-9)) << ", losses on time : " << results.timeLosses << "\n";
+
+	if (sprt.isEnabled) {
+		double llr(logLikelihoodRatio(results, sprt));
+
+		if (llr >= std::log((1 - sprt.beta) / sprt.alpha))
+			std::cout << "SPRT : H1 accepted, engine 1 is at least " << sprt.elo1 << " Elo stronger\n";
+		else if (llr <= std::log(sprt.beta / (1 - sprt.alpha)))
+			std::cout << "SPRT : H0 accepted, engine 1 is not " << sprt.elo1 << " Elo stronger\n";
+		else
+			std::cout << "SPRT : inconclusive\n";
+	}
+
+	return 0;
+}
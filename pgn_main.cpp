@@ -0,0 +1,174 @@
+#include "PgnReader.h"
+
+// Replays every game of a PGN file through Game, by chunks of the mapped file shared between threads.
+// Built like the UCI engine, with this file as main.
+//
+// pgn <file> [--threads <n>] [--errors <file>]
+// pgn --check                                : replays the movetexts of sChecks and compares the outcomes
+//
+// The games whose moves cannot be played are reported with their offset in the file, the ply and the move, on
+// stderr or in the errors file, by increasing offset.
+
+// Chunks of the file handed to the threads : a game belongs to the chunk of its first byte
+static const size_t sChunkSize = 4 << 20;
+
+struct ReplayStats
+{
+	u64 games;
+	u64 plies;
+	std::array<u64, 4> results; // White wins, Black wins, draws, unknown
+	std::vector<PgnError> errors;
+};
+
+// Movetexts and the ply of their first error, -1 if they must replay completely
+static const std::pair<const char*, int> sChecks[] = {
+	{ "1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 4. Ba4 Nf6 5. O-O Be7 1-0", -1 },
+	{ "1. a4 b5 2. axb5 *", -1 },
+	{ "1. a4 b5 2. b5 *", 2 },                              // A capture without the file of the pawn
+	{ "1. c4 b5 2. a4 e6 3. cxb5 *", -1 },
+	{ "1. c4 b5 2. a4 e6 3. b5 *", 4 },                     // Two captures, neither named
+	{ "1. e4 a6 2. e5 d5 3. exd6 *", -1 },
+	{ "1. e4 a6 2. e5 d5 3. d6 *", 4 },                     // En passant without the file of the pawn
+	{ "1. d4 e5 2. dxe5 d6 3. exd6 *", -1 },
+	{ "1. e4 d5 2. exd5 Qxd5 3. Nc3 Qa5 4. d4 c6 5. Nf3 Bg4 6. h3 Bxf3 7. Qxf3 e6 8. Bd2 Nf6 9. O-O-O *", -1 },
+	{ "[FEN \"8/1P6/8/8/8/8/6k1/K7 w - - 0 1\"]\n\n1. b8=Q *", -1 },
+	{ "[FEN \"8/1P6/8/8/8/8/6k1/K7 w - - 0 1\"]\n\n1. b8 *", 0 }, // A promotion without the piece
+	{ "1. e4 e5 2. Ke3 *", 2 }
+};
+
+static int check()
+{
+	u32 failures(0);
+
+	for (const std::pair<const char*, int>& check : sChecks) {
+		std::string_view text(check.first);
+		size_t split(text.find("\n\n"));
+		PgnGame game({ 0, split == std::string_view::npos ? std::string_view() : text.substr(0, split),
+		               split == std::string_view::npos ? text : text.substr(split + 2) });
+		PgnError error;
+		int ply(PgnReader::replay(game, nullptr, error) ? -1 : error.ply);
+
+		if (ply != check.second) {
+			std::cout << "Failed : " << check.first << " (error at ply " << ply << " instead of " << check.second << ")\n";
+			++failures;
+		}
+	}
+
+	std::cout << "Replay check : " << std::size(sChecks) - failures << "/" << std::size(sChecks) << " ok\n";
+
+	return failures ? 2 : 0;
+}
+
+static size_t resultIndex(std::string_view result)
+{
+	if (result == "1-0")
+		return 0;
+
+	if (result == "0-1")
+		return 1;
+
+	return result == "1/2-1/2" ? 2 : 3;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cerr << "Usage : pgn <file> [--threads <n>] [--errors <file>]\n";
+		std::cerr << "        pgn --check\n";
+		return 1;
+	}
+
+	if (std::string(argv[1]) == "--check")
+		return check();
+
+	unsigned threadsCount(std::max(std::thread::hardware_concurrency(), 1u));
+	std::string errorsPath;
+
+	for (int i(2); i + 1 < argc; i += 2) {
+		std::string option(argv[i]);
+
+		if (option == "--threads")
+			threadsCount = unsigned(std::max(std::atoi(argv[i + 1]), 1));
+		else if (option == "--errors")
+			errorsPath = argv[i + 1];
+		else {
+			std::cerr << "Unknown option " << option << "\n";
+			return 1;
+		}
+	}
+
+	PgnReader reader;
+
+	if (!reader.open(argv[1])) {
+		std::cerr << "Cannot open " << argv[1] << "\n";
+		return 1;
+	}
+
+	size_t chunksCount((reader.size() + sChunkSize - 1) / sChunkSize);
+	std::atomic<size_t> nextChunk(0);
+	std::vector<ReplayStats> stats(threadsCount, ReplayStats({ 0, 0, { 0, 0, 0, 0 }, std::vector<PgnError>() }));
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+
+	for (unsigned i(0); i < threadsCount; ++i) {
+		threads.emplace_back([&](ReplayStats& threadStats) {
+			PgnGame game;
+			PgnError error;
+			u64 plies(0);
+
+			auto countPly([&plies](const Game&, const Move&) { ++plies; });
+
+			for (size_t chunk(nextChunk++); chunk < chunksCount; chunk = nextChunk++) {
+				size_t end(std::min((chunk + 1) * sChunkSize, reader.size()));
+
+				for (size_t offset(reader.nextGame(chunk * sChunkSize)); offset < end;) {
+					offset = reader.read(offset, game);
+
+					++threadStats.games;
+					++threadStats.results[resultIndex(game.tag("Result"))];
+
+					if (!PgnReader::replay(game, countPly, error))
+						threadStats.errors.push_back(error);
+				}
+			}
+
+			threadStats.plies = plies;
+		}, std::ref(stats[i]));
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	double seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+
+	ReplayStats total({ 0, 0, { 0, 0, 0, 0 }, std::vector<PgnError>() });
+
+	for (ReplayStats& threadStats : stats) {
+		total.games += threadStats.games;
+		total.plies += threadStats.plies;
+
+		for (size_t i(0); i < 4; ++i)
+			total.results[i] += threadStats.results[i];
+
+		total.errors.insert(total.errors.end(), threadStats.errors.begin(), threadStats.errors.end());
+	}
+
+	std::sort(total.errors.begin(), total.errors.end(), [](const PgnError& e1, const PgnError& e2) { return e1.offset < e2.offset; });
+
+	std::ofstream errorsFile;
+
+	if (!errorsPath.empty())
+		errorsFile.open(errorsPath);
+
+	std::ostream& errors(errorsPath.empty() ? std::cerr : errorsFile);
+
+	for (const PgnError& error : total.errors)
+		errors << "Offset " << error.offset << ", ply " << error.ply << (error.move.empty() ? "" : ", move " + error.move) << " : " << error.reason << "\n";
+
+	std::cout << "Games : " << total.games << " (White wins " << total.results[0] << ", Black wins " << total.results[1]
+	          << ", draws " << total.results[2] << ", other " << total.results[3] << "), plies : " << total.plies << ", errors : " << total.errors.size() << "\n";
+	std::cout << reader.size() / 1048576. << " MB in " << seconds << " s with " << threadsCount << " threads : "
+	          << u64(60 * total.games / seconds) << " games/min, " << u64(total.plies / seconds) << " plies/s\n";
+
+	return total.errors.empty() ? 0 : 2;
+}
@@ -0,0 +1,179 @@
+#include "PositionDatabase.h"
+#include "PgnReader.h"
+
+// Position database of a PGN archive : the moves played from each position, with the results of their games.
+// Built like the UCI engine, with this file as main.
+//
+// posdb build <pgn> <database> [--plies <n>] [--threads <n>] [--run <MB>]
+// posdb query <database> [<fen>]
+//
+// The positions of the first --plies plies of each game are recorded (all of them with 0). Each thread sorts its
+// records by runs of --run MB per thread, written next to the database and merged at the end. Games without a
+// result are skipped.
+
+static const size_t sChunkSize = 4 << 20;
+
+static int build(const std::string& pgnPath, const std::string& path, u16 maxPlies, unsigned threadsCount, size_t runSize)
+{
+	PgnReader reader;
+
+	if (!reader.open(pgnPath)) {
+		std::cerr << "Cannot open " << pgnPath << "\n";
+		return 1;
+	}
+
+	PositionDatabaseBuilder builder(path);
+	size_t chunksCount((reader.size() + sChunkSize - 1) / sChunkSize), runRecords(std::max<size_t>(runSize / sizeof(PositionRecord), 1));
+	std::atomic<size_t> nextChunk(0);
+	std::atomic<u64> games(0), positions(0), errors(0);
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+
+	for (unsigned i(0); i < threadsCount; ++i) {
+		threads.emplace_back([&]() {
+			std::vector<PositionRecord> records;
+			PgnGame game;
+			PgnError error;
+			size_t result(0);
+			u16 ply(0);
+
+			records.reserve(runRecords);
+
+			auto record([&](const Game& board, const Move& move) {
+				if (maxPlies && ply >= maxPlies)
+					return;
+
+				PositionRecord position({ board.hash(), u16(move.type() << 12 | move.from() << 6 | move.to()), 0, { 0, 0, 0 } });
+				position.results[result] = 1;
+				records.push_back(position);
+
+				if (records.size() >= runRecords)
+					builder.addRun(records);
+
+				++ply;
+			});
+
+			for (size_t chunk(nextChunk++); chunk < chunksCount; chunk = nextChunk++) {
+				size_t end(std::min((chunk + 1) * sChunkSize, reader.size()));
+
+				for (size_t offset(reader.nextGame(chunk * sChunkSize)); offset < end;) {
+					offset = reader.read(offset, game);
+
+					std::string_view tag(game.tag("Result"));
+					result = tag == "1-0" ? 0 : tag == "1/2-1/2" ? 1 : tag == "0-1" ? 2 : 3;
+
+					if (result == 3)
+						continue;
+
+					ply = 0;
+
+					++games;
+					errors += !PgnReader::replay(game, record, error);
+					positions += ply;
+				}
+			}
+
+			builder.addRun(records);
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	double readSeconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+	u64 records(builder.finish());
+	double seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+
+	std::cout << "Games : " << games << " (" << errors << " with an illegal move), positions : " << positions << ", records : " << records << "\n";
+	std::cout << "Replayed and sorted in " << readSeconds << " s, merged in " << seconds - readSeconds << " s : "
+	          << std::filesystem::file_size(path) / 1048576. << " MB\n";
+
+	return 0;
+}
+
+static int query(const std::string& path, const std::string& fen)
+{
+	PositionDatabase database;
+
+	if (!database.open(path)) {
+		std::cerr << "Cannot open " << path << "\n";
+		return 1;
+	}
+
+	Game game(fen);
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::vector<PositionMove> moves(database.moves(game));
+	double first(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+
+	for (const PositionMove& move : moves) {
+		u32 games(move.results[0] + move.results[1] + move.results[2]);
+		double score(game.activePlayer() == White ? move.results[0] + .5 * move.results[1] : move.results[2] + .5 * move.results[1]);
+
+		std::cout << move.move.toString() << "\t" << games << " games\t+" << move.results[0] << " =" << move.results[1] << " -" << move.results[2]
+		          << "\t" << 100 * score / games << "%\n";
+	}
+
+	// The lookups of the legal moves of the position, the pages being in memory
+	const size_t repetitions(10000);
+	u64 found(0);
+
+	begin = std::chrono::steady_clock::now();
+
+	for (size_t i(0); i < repetitions; ++i)
+		found += database.moves(game).size();
+
+	double mean(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / repetitions);
+
+	std::cout << database.size() << " records, first lookup " << first << " us, then " << mean << " us per lookup\n";
+
+	return found == repetitions * moves.size() ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string command(argc > 1 ? argv[1] : "");
+
+	if (command == "build" && argc >= 4) {
+		u16 maxPlies(30);
+		unsigned threadsCount(std::max(std::thread::hardware_concurrency(), 1u));
+		size_t runSize(size_t(256) << 20);
+
+		for (int i(4); i + 1 < argc; i += 2) {
+			std::string option(argv[i]);
+			u64 value(std::strtoull(argv[i + 1], nullptr, 10));
+
+			if (option == "--plies")
+				maxPlies = u16(value);
+			else if (option == "--threads")
+				threadsCount = unsigned(std::max<u64>(value, 1));
+			else if (option == "--run")
+				runSize = std::max<u64>(value, 1) << 20;
+			else {
+				std::cerr << "Unknown option " << option << "\n";
+				return 1;
+			}
+		}
+
+		try {
+			return build(argv[2], argv[3], maxPlies, threadsCount, runSize);
+		} catch (const std::runtime_error& error) {
+			std::cerr << error.what() << "\n";
+			return 1;
+		}
+	}
+
+	if (command == "query" && argc >= 3) {
+		try {
+			return query(argv[2], argc > 3 ? argv[3] : "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+		} catch (const std::runtime_error& error) {
+			std::cerr << error.what() << "\n";
+			return 1;
+		}
+	}
+
+	std::cerr << "Usage : posdb build <pgn> <database> [--plies <n>] [--threads <n>] [--run <MB>]\n";
+	std::cerr << "        posdb query <database> [<fen>]\n";
+
+	return 1;
+}
@@ -0,0 +1,297 @@
+#include "Tablebases.h"
+
+// Checks the Syzygy decoding of Tablebases on sampled positions of the tables of a directory.
+// Built like the UCI engine, with this file as main.
+//
+// tbcheck <directory> [--positions <n>] [--seed <n>] [--fens <file>]  : consistency of each table with its children
+// tbcheck <directory> --reference <file>                             : comparison with another prober
+//
+// The consistency check samples random legal positions of each WDL table of the directory, with a halfmove clock of 0
+// and no castling. The WDL of each one must be the best of the WDL of its children, and its DTZ one more than the best
+// DTZ of its children, within the rounding of the tables which store moves instead of plies. A wrong index, Huffman
+// code or DTZ map gives unrelated values, which break these relations. Positions whose children need a missing table
+// are skipped. --fens writes the sampled positions, one FEN per line.
+//
+// The reference file holds lines "<fen>;<wdl>;<dtz>" written by another prober from such a list of positions, for
+// instance with the chess.syzygy module of python-chess, and every value must match.
+
+struct CheckStats
+{
+	u64 positions;
+	u64 skipped;
+	u64 wdlErrors;
+	u64 dtzErrors;
+};
+
+static int sign(int value)
+{
+	return (value > 0) - (value < 0);
+}
+
+// KRPvKR : the pieces of White, then of Black
+static bool parseMaterial(const std::string& name, std::string& pieces)
+{
+	size_t split(name.find('v'));
+
+	if (split == std::string::npos || name.find_first_not_of("KQRBNPv") != std::string::npos)
+		return false;
+
+	pieces = name.substr(0, split);
+
+	for (char piece : name.substr(split + 1))
+		pieces += char(std::tolower(piece));
+
+	return std::count(pieces.begin(), pieces.end(), 'K') == 1 && std::count(pieces.begin(), pieces.end(), 'k') == 1;
+}
+
+// A position of the pieces with the side to move not giving check
+static std::string randomPosition(const std::string& pieces, std::mt19937_64& random)
+{
+	for (;;) {
+		std::array<char, 64> board;
+		board.fill(0);
+
+		for (char piece : pieces) {
+			u8 square;
+
+			do
+				square = u8(random() % 64);
+			while (board[square] || (std::tolower(piece) == 'p' && (square < 8 || square >= 56)));
+
+			board[square] = piece;
+		}
+
+		std::string fen;
+
+		for (int rank(7); rank >= 0; --rank) {
+			int empty(0);
+
+			for (int file(0); file < 8; ++file) {
+				char piece(board[8 * rank + file]);
+
+				if (!piece) {
+					++empty;
+					continue;
+				}
+
+				if (empty)
+					fen += char('0' + empty);
+
+				fen += piece;
+				empty = 0;
+			}
+
+			if (empty)
+				fen += char('0' + empty);
+
+			if (rank)
+				fen += '/';
+		}
+
+		fen += random() % 2 ? " w - - 0 1" : " b - - 0 1";
+
+		Game game(fen);
+
+		if (!game.isKingInCheck(otherPlayer(game.activePlayer())))
+			return fen;
+	}
+}
+
+// The WDL and the DTZ of the position against the ones of its children
+static void checkPosition(Tablebases& tablebases, const std::string& fen, CheckStats& stats)
+{
+	Game game(fen);
+	WDLScore wdl;
+	bool isCacheHit;
+	int dtz;
+
+	if (!tablebases.probeWdl(&game, wdl, isCacheHit) || !tablebases.probeDtz(&game, dtz)) {
+		++stats.skipped;
+		return;
+	}
+
+	// Best result of the moves for the side to move, and the plies to the next zeroing move along the best line
+	int bestSign(-1), bestDtz(0);
+
+	if (!game.hasLegalMoves()) {
+		bestSign = game.isKingInCheck(game.activePlayer()) ? -1 : 0;
+		bestDtz = bestSign;
+	} else {
+		std::vector<std::pair<int, int>> children;
+
+		for (const Move& move : game.possibleMoves()) {
+			bool isZeroing(move.isCapture() || game.pieceType(move.from()) == Pawn);
+			WDLScore childWdl;
+			int childDtz(0);
+
+			game.makeMove(move);
+
+			bool isMate(game.isKingInCheck(game.activePlayer()) && !game.hasLegalMoves());
+			bool isProbed(tablebases.probeWdl(&game, childWdl, isCacheHit) && (isZeroing || tablebases.probeDtz(&game, childDtz)));
+
+			game.unmakeMove();
+
+			if (!isProbed) {
+				++stats.skipped;
+				return;
+			}
+
+			int childSign(-sign(childWdl));
+
+			children.push_back({ childSign, isZeroing || isMate ? childSign : -childDtz + childSign });
+			bestSign = std::max(bestSign, childSign);
+		}
+
+		// The winner converts as fast as possible, the loser resists as long as possible : the lowest value both ways
+		bestDtz = bestSign ? 0xFFFF : 0;
+
+		for (const std::pair<int, int>& child : children)
+			if (bestSign && child.first == bestSign)
+				bestDtz = std::min(bestDtz, child.second);
+	}
+
+	++stats.positions;
+
+	bool isWdlValid(sign(wdl) == bestSign && (std::abs(dtz) >= 100 || wdl == WDLDraw || std::abs(wdl) == 2) && (std::abs(dtz) <= 101 || std::abs(wdl) == 1));
+	bool isDtzValid(sign(dtz) == bestSign && std::abs(dtz - bestDtz) <= 1);
+
+	if (!isWdlValid || !isDtzValid) {
+		stats.wdlErrors += !isWdlValid;
+		stats.dtzErrors += !isDtzValid;
+
+		if (stats.wdlErrors + stats.dtzErrors <= 20)
+			std::cout << fen << " : WDL " << int(wdl) << ", DTZ " << dtz << ", expected from the children " << bestSign << " and " << bestDtz << "\n";
+	}
+}
+
+static int checkTables(Tablebases& tablebases, const std::string& directory, u64 positionsCount, u64 seed, const std::string& fensPath)
+{
+	std::vector<std::string> names;
+	std::error_code error;
+
+	for (const std::filesystem::directory_entry& file : std::filesystem::directory_iterator(directory, error))
+		if (file.path().extension() == ".rtbw")
+			names.push_back(file.path().stem().string());
+
+	std::sort(names.begin(), names.end(), [](const std::string& n1, const std::string& n2) { return n1.size() < n2.size() || (n1.size() == n2.size() && n1 < n2); });
+
+	std::ofstream fens;
+
+	if (!fensPath.empty())
+		fens.open(fensPath);
+
+	std::mt19937_64 random(seed);
+	CheckStats total({ 0, 0, 0, 0 });
+
+	for (const std::string& name : names) {
+		std::string pieces;
+
+		if (!parseMaterial(name, pieces) || pieces.size() > tablebases.maxPieces())
+			continue;
+
+		CheckStats stats({ 0, 0, 0, 0 });
+
+		for (u64 i(0); i < positionsCount; ++i) {
+			std::string fen(randomPosition(pieces, random));
+
+			if (fens.is_open())
+				fens << fen << "\n";
+
+			checkPosition(tablebases, fen, stats);
+		}
+
+		std::cout << name << " : " << stats.positions << " positions, " << stats.skipped << " skipped, " << stats.wdlErrors << " WDL errors, " << stats.dtzErrors << " DTZ errors\n";
+
+		total.positions += stats.positions;
+		total.skipped += stats.skipped;
+		total.wdlErrors += stats.wdlErrors;
+		total.dtzErrors += stats.dtzErrors;
+	}
+
+	std::cout << "Total : " << total.positions << " positions, " << total.skipped << " skipped, " << total.wdlErrors << " WDL errors, " << total.dtzErrors << " DTZ errors\n";
+
+	return total.wdlErrors || total.dtzErrors || !total.positions ? 2 : 0;
+}
+
+static int compareReference(Tablebases& tablebases, const std::string& path)
+{
+	std::ifstream file(path);
+	std::string line;
+	u64 positions(0), skipped(0), errors(0);
+
+	if (!file) {
+		std::cerr << "Cannot open " << path << "\n";
+		return 1;
+	}
+
+	while (std::getline(file, line)) {
+		size_t first(line.find(';')), second(line.find(';', first + 1));
+
+		if (second == std::string::npos)
+			continue;
+
+		std::string fen(line.substr(0, first));
+		int referenceWdl(std::stoi(line.substr(first + 1, second - first - 1))), referenceDtz(std::stoi(line.substr(second + 1)));
+
+		Game game(fen);
+		WDLScore wdl;
+		bool isCacheHit;
+		int dtz;
+
+		if (!tablebases.probeWdl(&game, wdl, isCacheHit) || !tablebases.probeDtz(&game, dtz)) {
+			++skipped;
+			continue;
+		}
+
+		++positions;
+
+		if (wdl != referenceWdl || dtz != referenceDtz) {
+			if (++errors <= 20)
+				std::cout << fen << " : WDL " << int(wdl) << ", DTZ " << dtz << ", reference " << referenceWdl << " and " << referenceDtz << "\n";
+		}
+	}
+
+	std::cout << "Reference : " << positions << " positions, " << skipped << " skipped, " << errors << " errors\n";
+
+	return errors || !positions ? 2 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cerr << "Usage : tbcheck <directory> [--positions <n>] [--seed <n>] [--fens <file>]\n";
+		std::cerr << "        tbcheck <directory> --reference <file>\n";
+		return 1;
+	}
+
+	u64 positionsCount(1000), seed(1);
+	std::string fensPath, referencePath;
+
+	for (int i(2); i + 1 < argc; i += 2) {
+		std::string option(argv[i]), value(argv[i + 1]);
+
+		if (option == "--positions")
+			positionsCount = std::strtoull(value.c_str(), nullptr, 10);
+		else if (option == "--seed")
+			seed = std::strtoull(value.c_str(), nullptr, 10);
+		else if (option == "--fens")
+			fensPath = value;
+		else if (option == "--reference")
+			referencePath = value;
+		else {
+			std::cerr << "Unknown option " << option << "\n";
+			return 1;
+		}
+	}
+
+	Tablebases tablebases;
+
+	if (!tablebases.init(argv[1])) {
+		std::cerr << "No tablebase found in " << argv[1] << "\n";
+		return 1;
+	}
+
+	std::cout << "Tablebases up to " << int(tablebases.maxPieces()) << " pieces\n";
+
+	return referencePath.empty() ? checkTables(tablebases, argv[1], positionsCount, seed, fensPath) : compareReference(tablebases, referencePath);
+}
@@ -0,0 +1,276 @@
+#include "SearchTrace.h"
+
+// Offline reader of the search traces recorded with CHESS_TRACE_SEARCH (UCI option TraceFile).
+// Built from defs, Move and this file only.
+//
+// trace <file> [iterations]                   : lists the recorded iterations
+// trace <file> tree <iteration> [plies]       : prints the tree of an iteration, 2 plies deep by default
+// trace <file> refute <iteration> <move>      : shows why a root move was not chosen, following its refutation
+
+struct TraceNode
+{
+	TraceRecord record;
+	std::vector<size_t> children;
+};
+
+struct TracedIteration
+{
+	u16 thread;
+	u16 search;
+	u8 depth;
+	std::vector<TraceNode> nodes;
+	size_t root;
+	bool isComplete;
+};
+
+static const size_t sNoNode = size_t(-1);
+
+static bool readTrace(const std::string& path, std::map<u16, std::vector<TraceRecord>>& records)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	char magic[4];
+	std::uint32_t recordSize(0);
+
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(&recordSize), sizeof(recordSize));
+
+	if (!file || !std::equal(magic, magic + 4, sTraceMagic) || recordSize != sizeof(TraceRecord))
+		return false;
+
+	TraceChunkHeader header;
+
+	while (file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		std::vector<TraceRecord>& thread(records[header.thread]);
+		size_t size(thread.size());
+
+		thread.resize(size + header.count);
+
+		if (!file.read(reinterpret_cast<char*>(&thread[size]), header.count * sizeof(TraceRecord)))
+			return false;
+	}
+
+	return true;
+}
+
+// The records are in post-order : the children of a node at ply p are the pending nodes at ply p + 1
+static void closeIteration(TracedIteration& iteration, std::vector<std::vector<size_t>>& pending)
+{
+	iteration.root = pending[0].empty() ? sNoNode : pending[0].back();
+	iteration.isComplete = iteration.root != sNoNode && !(iteration.nodes[iteration.root].record.flags & TraceInterrupted);
+
+	for (std::vector<size_t>& nodes : pending)
+		nodes.clear();
+}
+
+static std::vector<TracedIteration> buildIterations(const std::map<u16, std::vector<TraceRecord>>& records)
+{
+	std::vector<TracedIteration> iterations;
+	std::vector<std::vector<size_t>> pending(257);
+
+	for (const std::pair<const u16, std::vector<TraceRecord>>& thread : records) {
+		u16 search(0);
+		bool hasIteration(false);
+
+		for (const TraceRecord& record : thread.second) {
+			if (record.type == TraceIteration) {
+				if (hasIteration)
+					closeIteration(iterations.back(), pending);
+
+				// The depth restarts with each new search
+				if (hasIteration && record.depth <= iterations.back().depth)
+					++search;
+
+				iterations.push_back({ thread.first, search, record.depth, std::vector<TraceNode>(), sNoNode, false });
+				hasIteration = true;
+				continue;
+			}
+
+			if (!hasIteration)
+				continue;
+
+			TracedIteration& iteration(iterations.back());
+
+			iteration.nodes.push_back({ record, pending[record.ply + 1] });
+			pending[record.ply + 1].clear();
+			pending[record.ply].push_back(iteration.nodes.size() - 1);
+		}
+
+		if (hasIteration)
+			closeIteration(iterations.back(), pending);
+	}
+
+	return iterations;
+}
+
+static std::string formatScore(double score)
+{
+	if (std::abs(score) >= 100000)
+		return score > 0 ? "+inf" : "-inf";
+
+	char text[16];
+	snprintf(text, sizeof(text), "%+.2f", score);
+
+	return text;
+}
+
+static std::string formatNode(const TraceNode& node)
+{
+	const TraceRecord& record(node.record);
+
+	std::string text(record.ply ? decodeTraceMove(record.move).toString() : "root");
+	text += record.type == TraceQuiescenceNode ? "  qs" : "  d" + std::to_string(record.depth);
+	text += "  [" + formatScore(record.alpha) + ", " + formatScore(record.beta) + "]  " + formatScore(record.score);
+
+	if (record.score <= record.alpha)
+		text += "  all";
+	else if (record.score >= record.beta)
+		text += "  cut";
+	else
+		text += "  pv";
+
+	if (record.flags & TraceHashHit)
+		text += "  hash hit";
+
+	if (record.flags & TraceHashCutoff)
+		text += "  hash cutoff";
+
+	if (record.flags & TraceInterrupted)
+		text += "  interrupted";
+
+	return text;
+}
+
+// The child which gave its value to the node, from the point of view of the side to move at the node
+static size_t bestChild(const TracedIteration& iteration, const TraceNode& node)
+{
+	size_t best(sNoNode);
+
+	for (size_t child : node.children)
+		if (best == sNoNode || iteration.nodes[child].record.score < iteration.nodes[best].record.score)
+			best = child;
+
+	return best;
+}
+
+static void printTree(const TracedIteration& iteration, size_t node, u8 ply, u8 plies)
+{
+	std::cout << std::string(2 * ply, ' ') << formatNode(iteration.nodes[node]) << "\n";
+
+	if (ply < plies)
+		for (size_t child : iteration.nodes[node].children)
+			printTree(iteration, child, ply + 1, plies);
+}
+
+static void printIterations(const std::vector<TracedIteration>& iterations)
+{
+	for (size_t i(0); i < iterations.size(); ++i) {
+		const TracedIteration& iteration(iterations[i]);
+
+		std::cout << "#" << i << "  thread " << iteration.thread << "  search " << iteration.search << "  depth " << int(iteration.depth);
+		std::cout << "  " << iteration.nodes.size() << " nodes";
+
+		if (iteration.root != sNoNode) {
+			const TraceNode& root(iteration.nodes[iteration.root]);
+			size_t best(bestChild(iteration, root));
+
+			std::cout << "  score " << formatScore(root.record.score);
+
+			if (best != sNoNode)
+				std::cout << "  best " << decodeTraceMove(iteration.nodes[best].record.move).toString();
+		}
+
+		std::cout << (iteration.isComplete ? "" : "  (incomplete)") << "\n";
+	}
+}
+
+static int refute(const TracedIteration& iteration, const std::string& move)
+{
+	if (iteration.root == sNoNode) {
+		std::cerr << "The iteration has no root node\n";
+		return 1;
+	}
+
+	const TraceNode& root(iteration.nodes[iteration.root]);
+	size_t node(sNoNode), best(bestChild(iteration, root));
+
+	for (size_t child : root.children)
+		if (decodeTraceMove(iteration.nodes[child].record.move).toString() == move)
+			node = child;
+
+	if (node == sNoNode) {
+		std::cerr << move << " was not searched in this iteration\n";
+		return 1;
+	}
+
+	// A fail high of the reply only bounds the value of the move
+	const TraceRecord& record(iteration.nodes[node].record);
+
+	std::cout << move << " : " << (record.score >= record.beta ? "<= " : "") << formatScore(-record.score) << ", best move ";
+	std::cout << decodeTraceMove(iteration.nodes[best].record.move).toString() << " : " << formatScore(root.record.score) << "\n";
+
+	if (node == best)
+		std::cout << move << " is the best move of the iteration\n";
+
+	std::cout << "\nRefutation :\n";
+
+	for (u8 ply(1); node != sNoNode; ++ply) {
+		const TraceNode& current(iteration.nodes[node]);
+
+		std::cout << std::string(2 * ply, ' ') << formatNode(current);
+
+		if (current.record.flags & TraceHashCutoff)
+			std::cout << "  <- value from the transposition table";
+		else if (current.children.empty())
+			std::cout << (current.record.type == TraceQuiescenceNode ? "  <- static evaluation" : "  <- end of the game");
+
+		std::cout << "\n";
+
+		node = bestChild(iteration, current);
+	}
+
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cerr << "Usage : trace <file> [iterations | tree <iteration> [plies] | refute <iteration> <move>]\n";
+		return 1;
+	}
+
+	std::map<u16, std::vector<TraceRecord>> records;
+
+	if (!readTrace(argv[1], records)) {
+		std::cerr << "Cannot read the trace " << argv[1] << "\n";
+		return 1;
+	}
+
+	std::vector<TracedIteration> iterations(buildIterations(records));
+	std::string command(argc > 2 ? argv[2] : "iterations");
+
+	if (command == "iterations") {
+		printIterations(iterations);
+		return 0;
+	}
+
+	size_t index(argc > 3 ? std::strtoull(argv[3], nullptr, 10) : iterations.size());
+
+	if (index >= iterations.size()) {
+		std::cerr << "No iteration #" << (argc > 3 ? argv[3] : "") << "\n";
+		return 1;
+	}
+
+	if (command == "tree") {
+		if (iterations[index].root != sNoNode)
+			printTree(iterations[index], iterations[index].root, 0, argc > 4 ? std::atoi(argv[4]) : 2);
+
+		return 0;
+	}
+
+	if (command == "refute" && argc > 4)
+		return refute(iterations[index], argv[4]);
+
+	std::cerr << "Unknown command " << command << "\n";
+	return 1;
+}
@@ -0,0 +1,455 @@
+#include "AI.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Texel tuning of the piece values and of the piece-square tables of the evaluation.
+// Built like the UCI engine, with this file as main.
+//
+// tuner <epd> [epochs] [learning rate]
+//
+// Each line of the EPD file is a position followed by the result of its game : "1-0", "0-1", "1/2-1/2",
+// [1.0], [0.5] or [0.0]. The positions are first replaced by the leaf of their quiescence search, then the
+// parameters are fitted by full batch gradient descent, with Adam, on the logistic loss of the leaf evaluations.
+// The tuned tables are printed on the standard output in the format of AI.cpp, the progress on the error output.
+
+// Indices in the table of the evaluation terms : the White pieces at 64 * type + square, the Black pieces after them
+// at 384 + 64 * type + mirrored square, with the opposite sign. The padding of the positions points to a zero.
+static const u16 sBlackOffset = 384;
+static const u16 sPadding = 768;
+static const size_t sTableSize = 776;
+
+// The bishop pair term of the evaluation is not tuned
+static const double sBishopPair = .3;
+
+static const size_t sBatchLines = 1 << 20;
+
+struct TunedPosition
+{
+	std::array<u16, 32> pieces;
+	i8 bishopPairs;
+	float result;
+};
+
+struct Parameters
+{
+	std::array<double, 6> values;
+	std::array<std::array<double, 64>, 6> positional;
+};
+
+// Value and positional score of each piece on each square, as seen by White
+static std::vector<float> evaluationTable(const Parameters& parameters)
+{
+	std::vector<float> table(sTableSize, 0);
+
+	for (u8 type(0); type < 6; ++type) {
+		for (u8 square(0); square < 64; ++square) {
+			table[64 * type + square] = float(parameters.values[type] + parameters.positional[type][square]);
+			table[sBlackOffset + 64 * type + square] = -table[64 * type + square];
+		}
+	}
+
+	return table;
+}
+
+static TunedPosition extract(const Game& game, float result)
+{
+	TunedPosition position;
+	size_t count(0);
+
+	position.pieces.fill(sPadding);
+
+	for (u8 player(0); player < 2; ++player) {
+		for (u8 type(0); type < 6; ++type) {
+			u64 pieces(game.piecesOf(Player(player), PieceType(type)));
+
+			while (pieces && count < position.pieces.size()) {
+				u8 square(bsfReset(pieces));
+
+				if (player == White)
+					position.pieces[count++] = 64 * type + square;
+				else
+					position.pieces[count++] = sBlackOffset + 64 * type + (square ^ 56);
+			}
+		}
+	}
+
+	position.bishopPairs = (popcount(game.piecesOf(White, Bishop)) == 2) - (popcount(game.piecesOf(Black, Bishop)) == 2);
+	position.result = result;
+
+	return position;
+}
+
+// From White's point of view, in pawns
+static float evaluate(const TunedPosition& position, const float* table)
+{
+#if defined(__AVX2__)
+	__m256 sum(_mm256_setzero_ps());
+
+	for (size_t i(0); i < 32; i += 8) {
+		__m256i indices(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&position.pieces[i]))));
+		sum = _mm256_add_ps(sum, _mm256_i32gather_ps(table, indices, 4));
+	}
+
+	__m128 half(_mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+	half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+	half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+
+	return _mm_cvtss_f32(half) + float(sBishopPair) * position.bishopPairs;
+#else
+	float sum(0);
+
+	for (u16 index : position.pieces)
+		sum += table[index];
+
+	return sum + float(sBishopPair) * position.bishopPairs;
+#endif
+}
+
+// Captures only, as in the quiescence search of the engine : the losing captures are pruned and the others searched by
+// static exchange evaluation. The leaf of the principal variation is kept.
+static double quiescence(Game* game, double alpha, double beta, Player player, const std::vector<float>& table, TunedPosition& leaf)
+{
+	leaf = extract(*game, 0);
+
+	double standPat(playerSign(player) * evaluate(leaf, table.data()));
+
+	if (standPat >= beta || game->isOver())
+		return standPat;
+
+	alpha = std::max(alpha, standPat);
+
+	std::vector<std::pair<double, Move>> captures;
+
+	for (const Move& move : game->possibleMoves()) {
+		if (!move.isCapture())
+			continue;
+
+		double exchange(AI::see(*game, move));
+
+		if (exchange >= 0)
+			captures.push_back({ exchange, move });
+	}
+
+	std::stable_sort(captures.begin(), captures.end(), [](const std::pair<double, Move>& c1, const std::pair<double, Move>& c2) { return c1.first > c2.first; });
+
+	TunedPosition childLeaf;
+
+	for (const std::pair<double, Move>& capture : captures) {
+		game->makeMove(capture.second);
+		double v(-quiescence(game, -beta, -alpha, otherPlayer(player), table, childLeaf));
+		game->unmakeMove();
+
+		if (v > alpha) {
+			alpha = v;
+			leaf = childLeaf;
+
+			if (v >= beta)
+				break;
+		}
+	}
+
+	return alpha;
+}
+
+static bool parseResult(const std::string& line, float& result)
+{
+	if (line.find("1/2-1/2") != std::string::npos || line.find("[0.5]") != std::string::npos)
+		result = .5f;
+	else if (line.find("1-0") != std::string::npos || line.find("[1.0]") != std::string::npos)
+		result = 1;
+	else if (line.find("0-1") != std::string::npos || line.find("[0.0]") != std::string::npos)
+		result = 0;
+	else
+		return false;
+
+	return true;
+}
+
+static void resolveLines(const std::string* begin, const std::string* end, const std::vector<float>& table, std::vector<TunedPosition>& positions)
+{
+	for (const std::string* line(begin); line != end; ++line) {
+		std::istringstream stream(*line);
+		std::string placement, activePlayer, castlingRights, enPassant;
+		float result(0);
+
+		if (!(stream >> placement >> activePlayer >> castlingRights >> enPassant) || !parseResult(*line, result))
+			continue;
+
+		try {
+			Game game(placement + " " + activePlayer + " " + castlingRights + " " + enPassant);
+
+			if (game.isOver())
+				continue;
+
+			TunedPosition leaf;
+			quiescence(&game, -INFINITY, INFINITY, game.activePlayer(), table, leaf);
+			leaf.result = result;
+
+			positions.push_back(leaf);
+		} catch (const std::runtime_error&) {
+		}
+	}
+}
+
+// The lines are read by batches, each split between the threads, and kept in the order of the file
+static std::vector<TunedPosition> load(const std::string& path, const std::vector<float>& table, unsigned threadsCount)
+{
+	std::ifstream file(path);
+	std::vector<TunedPosition> positions;
+	std::vector<std::string> lines;
+
+	if (!file)
+		throw std::runtime_error("cannot open " + path);
+
+	while (file) {
+		std::string line;
+
+		lines.clear();
+
+		while (lines.size() < sBatchLines && std::getline(file, line))
+			lines.push_back(line);
+
+		std::vector<std::vector<TunedPosition>> resolved(threadsCount);
+		std::vector<std::thread> threads;
+		size_t chunk((lines.size() + threadsCount - 1) / threadsCount);
+
+		for (unsigned i(0); i < threadsCount; ++i) {
+			size_t begin(std::min(i * chunk, lines.size())), end(std::min(begin + chunk, lines.size()));
+			threads.emplace_back(resolveLines, lines.data() + begin, lines.data() + end, std::cref(table), std::ref(resolved[i]));
+		}
+
+		for (unsigned i(0); i < threadsCount; ++i) {
+			threads[i].join();
+			positions.insert(positions.end(), resolved[i].begin(), resolved[i].end());
+		}
+
+		std::cerr << "\rLoaded " << positions.size() << " positions" << std::flush;
+	}
+
+	std::cerr << "\n";
+
+	return positions;
+}
+
+static double sigmoid(double k, double score)
+{
+	return 1 / (1 + std::exp(-k * score));
+}
+
+// Sum of the losses and of their gradient with respect to the table entries
+static void accumulate(const TunedPosition* begin, const TunedPosition* end, const float* table, double k, double& loss, std::vector<double>* gradient)
+{
+	for (const TunedPosition* position(begin); position != end; ++position) {
+		double s(std::min(std::max(sigmoid(k, evaluate(*position, table)), 1e-7), 1 - 1e-7));
+
+		loss -= position->result * std::log(s) + (1 - position->result) * std::log(1 - s);
+
+		if (!gradient)
+			continue;
+
+		double g(k * (s - position->result));
+
+		for (u16 index : position->pieces)
+			(*gradient)[index] += g;
+	}
+}
+
+// Mean loss and mean gradient of the positions, split between the threads and summed in a fixed order
+static double epoch(const std::vector<TunedPosition>& positions, const std::vector<float>& table, double k, unsigned threadsCount, std::vector<double>* gradient)
+{
+	std::vector<double> losses(threadsCount, 0);
+	std::vector<std::vector<double>> gradients(threadsCount, std::vector<double>(gradient ? sTableSize : 0, 0));
+	std::vector<std::thread> threads;
+	size_t chunk((positions.size() + threadsCount - 1) / threadsCount);
+
+	for (unsigned i(0); i < threadsCount; ++i) {
+		size_t begin(std::min(i * chunk, positions.size())), end(std::min(begin + chunk, positions.size()));
+
+		threads.emplace_back(accumulate, positions.data() + begin, positions.data() + end, table.data(), k,
+		                     std::ref(losses[i]), gradient ? &gradients[i] : nullptr);
+	}
+
+	double loss(0);
+
+	if (gradient)
+		std::fill(gradient->begin(), gradient->end(), 0);
+
+	for (unsigned i(0); i < threadsCount; ++i) {
+		threads[i].join();
+		loss += losses[i];
+
+		if (gradient)
+			for (size_t j(0); j < sTableSize; ++j)
+				(*gradient)[j] += gradients[i][j] / positions.size();
+	}
+
+	return loss / positions.size();
+}
+
+// Scaling of the evaluation which best fits the results with the initial parameters
+static double fitScaling(const std::vector<TunedPosition>& positions, const std::vector<float>& table, unsigned threadsCount)
+{
+	double k(1), loss(epoch(positions, table, k, threadsCount, nullptr));
+
+	for (double step : { 1., .1, .01 }) {
+		for (int direction : { 1, -1 }) {
+			while (k + direction * step > 0) {
+				double stepLoss(epoch(positions, table, k + direction * step, threadsCount, nullptr));
+
+				if (stepLoss >= loss)
+					break;
+
+				k += direction * step;
+				loss = stepLoss;
+			}
+		}
+	}
+
+	return k;
+}
+
+// The King value is not tuned : each side always has its king
+static void tune(Parameters& parameters, const std::vector<TunedPosition>& positions, double k, size_t epochs, double learningRate, unsigned threadsCount)
+{
+	static const double sBeta1(.9), sBeta2(.999), sEpsilon(1e-8);
+
+	std::vector<double*> tuned;
+	std::vector<double> gradient(sTableSize), parametersGradient;
+
+	for (u8 type(0); type < King; ++type)
+		tuned.push_back(&parameters.values[type]);
+
+	for (u8 type(0); type < 6; ++type)
+		for (u8 square(0); square < 64; ++square)
+			tuned.push_back(&parameters.positional[type][square]);
+
+	std::vector<double> m(tuned.size(), 0), v(tuned.size(), 0);
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	for (size_t i(1); i <= epochs; ++i) {
+		double loss(epoch(positions, evaluationTable(parameters), k, threadsCount, &gradient));
+
+		// A term counts for White pieces and against Black pieces
+		parametersGradient.assign(tuned.size(), 0);
+
+		for (u8 type(0); type < 6; ++type) {
+			for (u8 square(0); square < 64; ++square) {
+				double g(gradient[64 * type + square] - gradient[sBlackOffset + 64 * type + square]);
+
+				if (type != King)
+					parametersGradient[type] += g;
+
+				parametersGradient[King + 64 * type + square] = g;
+			}
+		}
+
+		for (size_t j(0); j < tuned.size(); ++j) {
+			m[j] = sBeta1 * m[j] + (1 - sBeta1) * parametersGradient[j];
+			v[j] = sBeta2 * v[j] + (1 - sBeta2) * parametersGradient[j] * parametersGradient[j];
+
+			*tuned[j] -= learningRate * (m[j] / (1 - std::pow(sBeta1, i))) / (std::sqrt(v[j] / (1 - std::pow(sBeta2, i))) + sEpsilon);
+		}
+
+		if (i % 10 == 0 || i == epochs) {
+			double seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+			std::cerr << "Epoch " << i << "  loss " << loss << "  " << seconds / i << " s/epoch\n";
+		}
+	}
+}
+
+// Two decimals, written like the tables of AI.cpp : ".05", "-.20", "0."
+static std::string formatScore(double score)
+{
+	char text[16];
+	snprintf(text, sizeof(text), "%.2f", std::round(score * 100) / 100 + 0.);
+
+	std::string result(text);
+
+	if (result == "0.00" || result == "-0.00")
+		return "0.";
+
+	if (result.compare(0, 2, "0.") == 0)
+		result.erase(0, 1);
+	else if (result.compare(0, 3, "-0.") == 0)
+		result.erase(1, 1);
+
+	return result;
+}
+
+static std::string formatValue(double value)
+{
+	char text[16];
+	snprintf(text, sizeof(text), "%.2f", value);
+
+	std::string result(text);
+	result.erase(result.find_last_not_of('0') + 1);
+
+	if (result.back() == '.')
+		result.pop_back();
+
+	return result;
+}
+
+static void printParameters(const Parameters& parameters)
+{
+	static const std::array<std::string, 6> sNames = { "Pawn", "Knight", "Bishop", "Rook", "Queen", "King" };
+
+	std::cout << "std::array<double, 6> AI::sPiecesValues = { ";
+
+	for (u8 type(0); type < 6; ++type)
+		std::cout << formatValue(parameters.values[type]) << (type < 5 ? ", " : " };\n");
+
+	for (u8 type(0); type < 6; ++type) {
+		std::cout << "\n\tmPositionalScore[" << sNames[type] << "] =\n\t\t{ ";
+
+		for (u8 square(0); square < 64; ++square) {
+			std::cout << formatScore(parameters.positional[type][square]);
+
+			if (square == 63)
+				std::cout << " };\n";
+			else if (square % 8 == 7)
+				std::cout << ",\n\t\t  ";
+			else
+				std::cout << ", ";
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cerr << "Usage : tuner <epd> [epochs] [learning rate]\n";
+		return 1;
+	}
+
+	size_t epochs(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000);
+	double learningRate(argc > 3 ? std::atof(argv[3]) : .002);
+	unsigned threadsCount(std::max(std::thread::hardware_concurrency(), 1u));
+
+	AI ai(1);
+	Parameters parameters({ AI::piecesValues(), ai.positionalScores() });
+
+	std::vector<TunedPosition> positions;
+
+	try {
+		positions = load(argv[1], evaluationTable(parameters), threadsCount);
+	} catch (const std::runtime_error& error) {
+		std::cerr << error.what() << "\n";
+		return 1;
+	}
+
+	if (positions.empty()) {
+		std::cerr << "No labeled position in " << argv[1] << "\n";
+		return 1;
+	}
+
+	double k(fitScaling(positions, evaluationTable(parameters), threadsCount));
+	std::cerr << "Scaling " << k << "  initial loss " << epoch(positions, evaluationTable(parameters), k, threadsCount, nullptr) << "\n";
+
+	tune(parameters, positions, k, epochs, learningRate, threadsCount);
+	printParameters(parameters);
+
+	return 0;
+}
@@ -0,0 +1,18 @@
+#include "UCI.h"
+
+// Headless engine speaking UCI on the standard input and output.
+// Built from defs, Move, MoveGenerator, Game, TranspositionTable, TimeManager, AI and UCI only : no SFML.
+int main(int argc, char* argv[])
+{
+	UCI uci;
+
+	// "bench [depth]" prints the node signature of the search and exits
+	if (argc > 1 && std::string(argv[1]) == "bench") {
+		uci.bench(argc > 2 ? std::min(std::max(std::atoi(argv[2]), 1), 255) : UCI::sDefaultBenchDepth);
+		return 0;
+	}
+
+	uci.loop(std::cin);
+
+	return 0;
+}